@@ -15,56 +15,246 @@
 #include "pico/cyw43_arch.h"
 #include "lwip/udp.h"
 #include "hardware/timer.h"
+#include "hardware/watchdog.h"
 
 #include "lib/guante/guante.h"
+#include "lib/conexion/conexion.h"
+#include "lib/arranque/arranque.h"
+#include "lib/reposo/reposo.h"
+#include "lib/planificador/planificador.h"
+#include "lib/perfil/perfil.h"
+#include "lib/memoria/memoria.h"
 
 // --- CONFIGURACIÓN RED ---
 /** @brief SSID del hotspot Wi-Fi al que se conecta el guante. */
 #define WIFI_SSID     "iPhone de Felipe"
 /** @brief Contraseña del hotspot Wi-Fi. */
 #define WIFI_PASSWORD "ff11223344"
-/** @brief Dirección IP del servidor (mano robótica). */
-#define SERVER_IP     "172.20.10.2"
-/** @brief Puerto UDP usado para enviar las tramas al servidor. */
+/** @brief Timeout del watchdog (ms); el main nunca bloquea, así que se refresca en cada vuelta. */
+#define WATCHDOG_TIMEOUT_MS 5000
+/** @brief Periodo de impresión de la carga de CPU y de las tareas (ms). */
+#define PERIODO_CPU_MS      5000
+/** @brief Periodo de la tarea de red: conexión Wi-Fi y descubrimiento (µs). */
+#define PERIODO_RED_US      10000
+/** @brief Periodo de lectura de la consola serie (µs). */
+#define PERIODO_CONSOLA_US  50000
+/** @brief 1 para arrancar con la IP de la sesión anterior mientras DHCP confirma (ver lib/ipcache). */
+#define IP_CACHE_HABILITADA 0
+/** @brief Espera máxima a que se abra la consola USB, solo si hay un host conectado (ms). */
+#define USB_ESPERA_MAX_MS   3000
+/** @brief Puerto UDP de la mano: tramas, sondas de descubrimiento y ACK. */
 #define UDP_PORT      4242
 
+/** @brief Envío unicast a la mano descubierta (una sola mano). */
+#define ENVIO_UNICAST    0
+/** @brief Envío al grupo multicast MULTICAST_GRUPO (todas las manos unidas al grupo). */
+#define ENVIO_MULTICAST  1
+/** @brief Envío al broadcast de la subred (todas las manos de la red). */
+#define ENVIO_BROADCAST  2
+/**
+ * @brief Modo de envío de las tramas.
+ *
+ * En modo multicast o broadcast el guante envía cada trama una sola vez y
+ * cualquier número de manos la aplica.
+ */
+#define MODO_ENVIO       ENVIO_UNICAST
+/** @brief Grupo multicast compartido con las manos (debe coincidir con el servidor). */
+#define MULTICAST_GRUPO  "239.42.42.42"
+
+// --- CONFIGURACIÓN DESCUBRIMIENTO ---
+/** @brief Intervalo entre sondas `D?` mientras se busca la mano (ms). */
+#define DESCUBRIMIENTO_REINTENTO_MS 250
+/** @brief Tiempo sin ACK de la mano tras el cual se vuelve a descubrir (ms). */
+#define ACK_TIMEOUT_MS              2000
+
+// --- CONFIGURACIÓN TRAMA ---
+/** @brief Periodo de muestreo de los sensores en microsegundos (500 Hz). */
+#define PERIODO_MUESTREO_US 2000
+/**
+ * @brief Muestras nuevas por datagrama (tamaño de lote).
+ *
+ * Perilla latencia/eficiencia: la tasa de paquetes es
+ * 1 / (MUESTRAS_POR_TRAMA * PERIODO_MUESTREO_US) y cada muestra espera en el
+ * guante hasta (MUESTRAS_POR_TRAMA - 1) periodos antes de enviarse.
+ */
+#define MUESTRAS_POR_TRAMA  10
+/**
+ * @brief Número de lotes previos repetidos en cada trama (redundancia).
+ *
+ * Con K > 0 cada datagrama lleva, además del lote actual, las muestras de los
+ * K lotes anteriores con su número de secuencia. El servidor reconstruye los
+ * estados perdidos sin necesidad de ACK ni retransmisión. K = 0 desactiva la redundancia.
+ */
+#define REDUNDANCIA_K       1
+/** @brief Muestras guardadas en el historial (lote actual + redundancia). */
+#define HISTORIAL_LEN       ((REDUNDANCIA_K + 1) * MUESTRAS_POR_TRAMA)
+/** @brief Tamaño del buffer de trama: cabecera + 6 caracteres por muestra. */
+#define TRAMA_MAX_LEN       (64 + 6 * HISTORIAL_LEN)
+/**
+ * @brief Porcentaje de pérdida simulada en el envío (0 = desactivado).
+ *
+ * Solo para pruebas: descarta al azar datagramas antes de enviarlos para medir
+ * la pérdida efectiva en el servidor bajo 5–20 % de pérdida.
+ */
+#define SIM_PERDIDA_PCT  0
+/**
+ * @brief 1 para imprimir cada trama enviada como `TX[n]: S,...` (depuración y grabación de sesiones).
+ *
+ * Apagado por defecto: imprimir 150+ bytes a 50 Hz domina el tiempo de la
+ * tarea de muestreo. Se activa con `-DLOG_TRAMAS=ON` al configurar CMake.
+ */
+#ifndef LOG_TRAMAS
+#define LOG_TRAMAS       0
+#endif
+
+// --- PLANIFICADOR ---
+/** @brief Planificador cooperativo del bucle principal. */
+static planificador_t plan;
+/** @brief Tarea por evento que lee los dedos; la señala la IRQ del timer. */
+static int tarea_muestreo = -1;
+/** @brief Tarea periódica de red; también la señala el callback UDP. */
+static int tarea_red = -1;
+
+// --- PERFIL (solo builds con PERFIL_HABILITADO) ---
+PERFIL_DEFINIR(perfil_timer_irq, "timer_irq");
+PERFIL_DEFINIR(perfil_udp_rx_irq, "udp_client_recv");
+PERFIL_DEFINIR(perfil_poll, "cyw43_poll");
+PERFIL_DEFINIR(perfil_leer_dedos, "guante_leer_dedos");
+PERFIL_DEFINIR(perfil_envio, "send_string");
+
 // --- VARIABLES VOLÁTILES (Compartidas entre IRQ y Main) ---
 // volatile es OBLIGATORIO para variables modificadas en interrupciones
-/** @brief Bandera levantada por la IRQ de timer para indicar envío periódico. */
-static volatile bool flag_timer_send = false;
-
+/** @brief Gestor asíncrono de la conexión Wi-Fi. */
+static conexion_t wifi;
+/** @brief Medida del tiempo en reposo del bucle principal. */
+static reposo_t reposo;
 /** @brief PCB UDP del cliente (guante). */
 static struct udp_pcb *udp_client_pcb = NULL;
 /** @brief Indica si la conexión UDP está lista para enviar. */
 static bool udp_ready = false;
+/** @brief Destino actual de las tramas (mano descubierta, grupo o broadcast). */
+static ip_addr_t destino_ip;
+/** @brief Indica si destino_ip es válido. */
+static bool destino_valido = false;
+
+/** @brief Respuesta de descubrimiento pendiente de procesar (escrita por el callback UDP). */
+static volatile bool flag_respuesta = false;
+/** @brief IP anunciada por la mano en la última respuesta. */
+static ip_addr_t respuesta_ip;
+/** @brief Capacidades anunciadas por la mano en la última respuesta. */
+static volatile uint32_t respuesta_caps = 0;
+/** @brief ACK recibido y pendiente de procesar (escrito por el callback UDP). */
+static volatile bool flag_ack = false;
+/** @brief Última secuencia confirmada como aplicada por la mano. */
+static volatile uint32_t ultimo_seq_ack = 0;
+/** @brief Instante del último ACK recibido (ms desde el arranque). */
+static volatile uint32_t t_ultimo_ack_ms = 0;
+
+/** @brief Indica si se está buscando la mano con sondas. */
+static bool buscando = false;
+/** @brief Instante en que empezó la búsqueda actual (ms desde el arranque). */
+static uint32_t t_inicio_busqueda_ms = 0;
+/** @brief Instante de la última sonda enviada (ms desde el arranque). */
+static uint32_t t_ultima_sonda_ms = 0;
+/** @brief Falta informar el tiempo hasta el primer frame aplicado. */
+static bool primer_ack_pendiente = true;
+
 /** @brief Contador de paquetes enviados por el cliente. */
 static uint32_t tx_packet_count = 0;
+/** @brief Contador de paquetes descartados por la pérdida simulada. */
+static uint32_t tx_sim_drop_count = 0;
+
+/** @brief Número de secuencia del último estado leído. */
+static uint32_t seq_estado = 0;
+/** @brief Marca de tiempo (time_us_32) del último estado leído. */
+static uint32_t t_ultimo_estado = 0;
+/** @brief Muestras leídas desde el último envío. */
+static uint32_t muestras_en_lote = 0;
+/**
+ * @brief Historial circular de los últimos estados en orden de trama.
+ *
+ * La posición (seq % HISTORIAL_LEN) guarda el estado con esa secuencia.
+ */
+static uint8_t historial[HISTORIAL_LEN][GUANTE_NUM_DEDOS];
 
 // --- RUTINA DE INTERRUPCIÓN (TIMER IRQ) ---
-// Esta función se ejecuta automáticamente cada 250ms
+// Esta función se ejecuta automáticamente cada PERIODO_MUESTREO_US
 /**
- * @brief Callback del timer periódico para disparar el envío de datos.
+ * @brief Callback del timer periódico para disparar el muestreo de los dedos.
  *
- * Solo levanta una bandera para que el envío real se haga en el main,
- * manteniendo la ISR lo más corta posible.
+ * Solo señala la tarea de muestreo para que la lectura y el envío se hagan en
+ * el main, manteniendo la ISR lo más corta posible.
  *
  * @param t Puntero al timer que generó la interrupción.
  * @return true para que el timer siga repitiéndose.
  */
-bool send_timer_callback(struct repeating_timer *t) {
-    // Solo levantamos la bandera. Mantener la IRQ lo más corta posible.
-    flag_timer_send = true;
+bool muestreo_timer_callback(struct repeating_timer *t) {
+    PERFIL_SONDA(perfil_timer_irq);
+    // Solo señalamos la tarea. Mantener la IRQ lo más corta posible.
+    planificador_senalar(&plan, tarea_muestreo);
+    __sev(); // Despierta al main aunque la señal llegue justo antes del WFE
     return true; // true para mantener el timer repitiéndose
 }
 
 // --- UDP ---
 /**
- * @brief Crea y conecta el PCB UDP al servidor configurado.
+ * @brief Calcula el broadcast dirigido de la subred actual (ip | ~máscara).
  *
- * Crea un nuevo PCB UDP, lo conecta a la IP y puerto del servidor y
- * marca udp_ready en caso de éxito.
+ * @param[out] out Dirección de broadcast.
+ */
+static void broadcast_subred(ip_addr_t *out) {
+    const struct netif *n = &cyw43_state.netif[CYW43_ITF_STA];
+    ip4_addr_set_u32(out, ip4_addr_get_u32(netif_ip4_addr(n)) | ~ip4_addr_get_u32(netif_ip4_netmask(n)));
+}
+
+/**
+ * @brief Callback de recepción UDP del guante (respuestas de descubrimiento y ACK).
  *
- * @return true si la conexión UDP se configuró correctamente.
+ * - `D!,<ip>,<puerto>,<caps>`: respuesta de una mano a la sonda de descubrimiento.
+ * - `A,<seq>`: confirmación periódica de la mano con la última secuencia aplicada.
+ *
+ * Solo copia los datos a variables volátiles; el main decide qué hacer.
+ *
+ * @param arg Puntero opcional de usuario (no usado).
+ * @param pcb PCB UDP que recibe los datos.
+ * @param p Estructura pbuf con la carga útil recibida.
+ * @param addr Dirección IP del emisor.
+ * @param port Puerto UDP de origen.
+ */
+static void udp_client_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                            const ip_addr_t *addr, u16_t port) {
+    PERFIL_SONDA(perfil_udp_rx_irq);
+    if (!p) return;
+
+    char buffer[48];
+    u16_t len = pbuf_copy_partial(p, buffer, sizeof(buffer) - 1, 0);
+    buffer[len] = '\0';
+    pbuf_free(p);
+
+    if (buffer[0] == 'D' && buffer[1] == '!') {
+        char ip_txt[16];
+        unsigned long caps = 0;
+        if (sscanf(buffer, "D!,%15[^,],%*u,%lx", ip_txt, &caps) != 2) return;
+        if (!ip4addr_aton(ip_txt, &respuesta_ip)) return;
+        respuesta_caps = (uint32_t)caps;
+        flag_respuesta = true;
+    } else if (buffer[0] == 'A' && buffer[1] == ',') {
+        ultimo_seq_ack = (uint32_t)strtoul(buffer + 2, NULL, 10);
+        t_ultimo_ack_ms = to_ms_since_boot(get_absolute_time());
+        flag_ack = true;
+    }
+    planificador_senalar(&plan, tarea_red);
+    __sev(); // Despierta al main si estaba en reposo
+}
+
+/**
+ * @brief Crea el PCB UDP del guante.
+ *
+ * El PCB no se conecta: se enlaza a un puerto local efímero para recibir
+ * respuestas y ACK, y cada envío indica su destino. No necesita que el
+ * enlace Wi-Fi esté arriba; el destino se fija en actualizar_destino().
+ *
+ * @return true si el PCB UDP se configuró correctamente.
  */
 static bool udp_client_connect(void) {
     if (udp_client_pcb) {
@@ -74,93 +264,361 @@ static bool udp_client_connect(void) {
     udp_client_pcb = udp_new_ip_type(IPADDR_TYPE_V4);
     if (!udp_client_pcb) return false;
 
-    ip_addr_t srv_ip;
-    ip4addr_aton(SERVER_IP, &srv_ip);
-
-    err_t err = udp_connect(udp_client_pcb, &srv_ip, UDP_PORT);
-    if (err != ERR_OK) {
+    if (udp_bind(udp_client_pcb, IP_ANY_TYPE, 0) != ERR_OK) {
         udp_remove(udp_client_pcb);
+        udp_client_pcb = NULL;
         return false;
     }
+    ip_set_option(udp_client_pcb, SOF_BROADCAST); // Sondas y modo broadcast
+    udp_recv(udp_client_pcb, udp_client_recv, NULL);
+
     udp_ready = true;
     return true;
 }
 
 /**
- * @brief Envía una cadena de texto por UDP al servidor.
+ * @brief Fija el destino de las tramas según MODO_ENVIO al obtener IP.
+ *
+ * En modo unicast el destino lo fija el descubrimiento; en multicast es el
+ * grupo y en broadcast se recalcula con la IP/máscara de la concesión actual.
+ */
+static void actualizar_destino(void) {
+#if MODO_ENVIO == ENVIO_MULTICAST
+    ip4addr_aton(MULTICAST_GRUPO, &destino_ip);
+    destino_valido = true;
+#elif MODO_ENVIO == ENVIO_BROADCAST
+    broadcast_subred(&destino_ip);
+    destino_valido = true;
+#endif
+    if (destino_valido) printf("Destino UDP: %s:%d\n", ipaddr_ntoa(&destino_ip), UDP_PORT);
+}
+
+/**
+ * @brief Envía una cadena de texto por UDP a una dirección.
  *
  * Reserva un pbuf, copia la cadena y la envía usando el PCB UDP del cliente.
  *
  * @param data Puntero a la cadena terminada en '\0' a enviar.
+ * @param ip Dirección IP de destino.
  */
-static void send_string(const char *data) {
+static void send_string_to(const char *data, const ip_addr_t *ip) {
+    PERFIL_SONDA(perfil_envio);
     if (!udp_ready || !udp_client_pcb) return;
-    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, (u16_t)strlen(data), PBUF_RAM);
-    if (!p) return;
-    memcpy(p->payload, data, strlen(data));
-    udp_send(udp_client_pcb, p);
-    pbuf_free(p);
+    u16_t len = (u16_t)strlen(data);
+
+    // Los callbacks de lwIP corren en IRQ (threadsafe_background): bloquear la pila
+    cyw43_arch_lwip_begin();
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+    if (p) {
+        memcpy(p->payload, data, len);
+        udp_sendto(udp_client_pcb, p, ip, UDP_PORT);
+        pbuf_free(p);
+    }
+    cyw43_arch_lwip_end();
+}
+
+/**
+ * @brief Envía una cadena de texto por UDP al destino actual (mano, grupo o broadcast).
+ *
+ * @param data Puntero a la cadena terminada en '\0' a enviar.
+ */
+static void send_string(const char *data) {
+    if (!destino_valido) return;
+    send_string_to(data, &destino_ip);
+}
+
+// --- DESCUBRIMIENTO ---
+/**
+ * @brief Entra en modo búsqueda de la mano y reinicia la medida hasta el primer frame aplicado.
+ *
+ * Mientras busca, el guante sigue enviando las tramas a la última mano
+ * conocida (caché) por si solo se perdieron algunos ACK. En multicast/broadcast
+ * no hay búsqueda, solo se reinicia la medida.
+ *
+ * @param desde_ms Origen de la medida (arranque, caída del enlace o último ACK), en ms.
+ */
+static void iniciar_busqueda(uint32_t desde_ms) {
+#if MODO_ENVIO == ENVIO_UNICAST
+    buscando = true;
+    t_ultima_sonda_ms = to_ms_since_boot(get_absolute_time()) - DESCUBRIMIENTO_REINTENTO_MS; // Sonda inmediata
+#endif
+    t_inicio_busqueda_ms = desde_ms;
+    primer_ack_pendiente = true;
+}
+
+/**
+ * @brief Máquina de descubrimiento y vigilancia de ACK (se llama en cada vuelta del main).
+ *
+ * - Con una respuesta `D!` adopta (y guarda en caché) la IP de la mano.
+ * - Con el primer ACK tras arrancar o redescubrir, informa el tiempo hasta
+ *   el primer frame aplicado.
+ * - En modo unicast, si no llega ningún ACK en ACK_TIMEOUT_MS, vuelve a
+ *   buscar enviando sondas `D?` al broadcast de la subred.
+ */
+static void descubrimiento_tick(void) {
+    uint32_t ahora_ms = to_ms_since_boot(get_absolute_time());
+
+    if (flag_respuesta) {
+        flag_respuesta = false;
+        bool cambio = !destino_valido || !ip_addr_cmp(&destino_ip, &respuesta_ip);
+        ip_addr_copy(destino_ip, respuesta_ip);
+        destino_valido = true;
+        if (buscando) {
+            buscando = false;
+            t_ultimo_ack_ms = ahora_ms; // Plazo completo para el primer ACK
+            printf("[DESC] mano %s caps=0x%02lx%s en %lu ms\n", ipaddr_ntoa(&destino_ip),
+                   respuesta_caps, cambio ? " (nueva IP)" : "", ahora_ms - t_inicio_busqueda_ms);
+        }
+    }
+
+    if (flag_ack) {
+        flag_ack = false;
+        if (primer_ack_pendiente) {
+            static bool primer_frame_marcado = false;
+            primer_ack_pendiente = false;
+            if (!primer_frame_marcado) {
+                primer_frame_marcado = true;
+                arranque_marcar("primer_frame");
+            }
+            printf("[DESC] primer frame aplicado (seq %lu) a los %lu ms\n",
+                   ultimo_seq_ack, ahora_ms - t_inicio_busqueda_ms);
+        }
+    }
+
+#if MODO_ENVIO == ENVIO_UNICAST
+    if (!buscando && (int32_t)(ahora_ms - t_ultimo_ack_ms) > ACK_TIMEOUT_MS) {
+        printf("[DESC] sin ACK en %d ms, redescubriendo\n", ACK_TIMEOUT_MS);
+        iniciar_busqueda(t_ultimo_ack_ms);
+    }
+    if (buscando && ahora_ms - t_ultima_sonda_ms >= DESCUBRIMIENTO_REINTENTO_MS) {
+        t_ultima_sonda_ms = ahora_ms;
+        ip_addr_t bcast;
+        broadcast_subred(&bcast);
+        send_string_to("D?", &bcast);
+    }
+#endif
+}
+
+// --- TRAMA ---
+/**
+ * @brief Arma una trama secuenciada con el lote actual y los K lotes anteriores.
+ *
+ * Formato: `S,<seq>,<t_us>,<periodo_us>,<n>,<e0>,...,<e(n-1)>`, donde los
+ * estados van del más antiguo al más reciente, `seq` y `t_us` corresponden
+ * al más reciente y cada estado son 5 dígitos (un dígito por dedo, mismo
+ * orden que la trama clásica `H`). La marca de tiempo del estado i es
+ * `t_us - (n - 1 - i) * periodo_us`.
+ *
+ * @param buf Buffer de salida.
+ * @param len Tamaño del buffer.
+ * @return Longitud de la trama escrita.
+ */
+static int armar_trama(char *buf, size_t len) {
+    // Al arrancar todavía no hay K lotes previos
+    uint32_t n = (seq_estado <= HISTORIAL_LEN) ? seq_estado : HISTORIAL_LEN;
+
+    int pos = snprintf(buf, len, "S,%lu,%lu,%lu,%lu",
+                       (unsigned long)seq_estado, (unsigned long)t_ultimo_estado,
+                       (unsigned long)PERIODO_MUESTREO_US, (unsigned long)n);
+
+    for (uint32_t i = 0; i < n && pos > 0 && (size_t)pos < len; i++) {
+        uint32_t seq_i = seq_estado - (n - 1 - i);
+        const uint8_t *e = historial[seq_i % HISTORIAL_LEN];
+        pos += snprintf(buf + pos, len - (size_t)pos, ",%u%u%u%u%u",
+                        e[0], e[1], e[2], e[3], e[4]);
+    }
+    return pos;
+}
+
+// --- TAREAS ---
+/**
+ * @brief Tarea de muestreo: lee los dedos y envía una trama cada MUESTRAS_POR_TRAMA muestras.
+ *
+ * La señala la IRQ del timer cada PERIODO_MUESTREO_US. Sin red las muestras
+ * siguen entrando al historial y solo se omite el envío.
+ *
+ * @param ctx No usado.
+ */
+static void tarea_muestreo_fn(void *ctx) {
+    static char buffer_trama[TRAMA_MAX_LEN];
+
+    // Ejecutamos la lógica "pesada" fuera de la interrupción
+    uint8_t dedos[GUANTE_NUM_DEDOS];
+    {
+        PERFIL_SONDA(perfil_leer_dedos);
+        guante_leer_dedos(dedos);
+    }
+
+    // Guardamos el estado en el historial con el orden de la trama
+    t_ultimo_estado = time_us_32();
+    seq_estado++;
+    uint8_t *e = historial[seq_estado % HISTORIAL_LEN];
+    e[0] = dedos[4]; e[1] = dedos[3]; e[2] = dedos[2]; e[3] = dedos[0]; e[4] = dedos[1];
+
+    // Solo se envía cuando el lote está completo
+    if (++muestras_en_lote < MUESTRAS_POR_TRAMA) return;
+    muestras_en_lote = 0;
+
+    armar_trama(buffer_trama, sizeof(buffer_trama));
+
+    // Pérdida simulada (solo pruebas): el estado queda en el historial
+    if (SIM_PERDIDA_PCT > 0 && (rand() % 100) < SIM_PERDIDA_PCT) {
+        tx_sim_drop_count++;
+        printf("TX[-]: descartada (sim %lu)\n", tx_sim_drop_count);
+        return;
+    }
+
+    // Sin red las muestras siguen en el historial; al volver sale el último lote
+    if (!conexion_lista(&wifi)) return;
+
+    send_string(buffer_trama);
+
+    tx_packet_count++;
+#if LOG_TRAMAS
+    printf("TX[%lu]: %s\n", tx_packet_count, buffer_trama);
+#endif
+}
+
+/**
+ * @brief Tarea de red: avanza la conexión Wi-Fi y el descubrimiento de la mano.
+ *
+ * Periódica cada PERIODO_RED_US; el callback UDP la adelanta al llegar una
+ * respuesta o un ACK.
+ *
+ * @param ctx No usado.
+ */
+static void tarea_red_fn(void *ctx) {
+    switch (conexion_tick(&wifi)) {
+    case CONEXION_EVENTO_CONECTADO:
+        if (wifi.conexiones == 1) arranque_marcar("wifi_ip");
+        printf("WiFi Conectado: %s\n", ip4addr_ntoa(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA])));
+        conexion_imprimir(&wifi);
+        actualizar_destino();
+        // Medir hasta el primer frame aplicado desde el arranque o desde la caída
+        iniciar_busqueda(wifi.conexiones == 1 ? 0 : wifi.t_corte_ms);
+        break;
+    case CONEXION_EVENTO_IP_CAMBIADA:
+        // DHCP no confirmó la IP en caché: el broadcast dirigido depende de la concesión
+        printf("WiFi IP (DHCP): %s\n", ip4addr_ntoa(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA])));
+        actualizar_destino();
+        break;
+    case CONEXION_EVENTO_CAIDA:
+        printf("WiFi caido, reconectando (el muestreo sigue)\n");
+        break;
+    default:
+        break;
+    }
+    if (conexion_lista(&wifi)) descubrimiento_tick();
+}
+
+/**
+ * @brief Tarea de estadísticas: carga de CPU, tiempos de cada tarea y memoria.
+ * @param ctx No usado.
+ */
+static void tarea_cpu_fn(void *ctx) {
+    reposo_imprimir(&reposo);
+    planificador_imprimir(&plan);
+    memoria_imprimir();
+}
+
+/**
+ * @brief Tarea de consola: 't' vuelca y reinicia los tiempos por sección (lib/perfil).
+ * @param ctx No usado.
+ */
+static void tarea_consola_fn(void *ctx) {
+    if (getchar_timeout_us(0) == 't') perfil_imprimir();
 }
 
 // --- MAIN ---
 /**
  * @brief Punto de entrada del cliente (guante).
  *
- * Inicializa stdio, Wi-Fi, la librería del guante y la conexión UDP.
- * Configura un timer en IRQ cada 250 ms y, en el loop principal, realiza
- * polling de la pila de red y envía tramas periódicas con las lecturas de los dedos.
+ * Registra las tareas del planificador y arranca primero el muestreo (guante y
+ * timer en IRQ cada PERIODO_MUESTREO_US), después el chip Wi-Fi y el PCB UDP, y
+ * lanza la conexión Wi-Fi de forma asíncrona. Solo espera al USB si hay un host
+ * conectado, y registra cada fase en la traza de arranque. El loop principal
+ * ejecuta las tareas listas por prioridad (muestreo, red, consola, estadísticas) y, sin
+ * trabajo, duerme en WFE hasta la próxima activación o IRQ.
+ * Sin red el muestreo sigue y las muestras quedan en el historial.
  *
- * @return 0 en operación normal, 1 si falla la inicialización.
+ * @return No retorna; si el chip Wi-Fi no inicia, reinicia la placa.
  */
 int main() {
+    // Antes que nada: lo que quede sin pintar es uso real de la pila
+    memoria_pintar_pilas();
     stdio_init_all();
-    sleep_ms(3000); // Espera inicial única para USB
-    printf("=== GUANTE (CLIENTE): Arq. Polling + IRQ ===\n");
+    arranque_marcar("stdio");
 
-    if (cyw43_arch_init()) return 1;
-    cyw43_wifi_pm(&cyw43_state, CYW43_NO_POWERSAVE_MODE);
-    cyw43_arch_enable_sta_mode();
+    // Tareas del bucle principal (0 = mayor prioridad)
+    planificador_init(&plan, time_us_32);
+    tarea_muestreo = planificador_evento(&plan, "muestreo", tarea_muestreo_fn, NULL, 0, PERIODO_MUESTREO_US);
+    tarea_red = planificador_periodica(&plan, "red", tarea_red_fn, NULL, 1, PERIODO_RED_US);
+    planificador_periodica(&plan, "consola", tarea_consola_fn, NULL, 2, PERIODO_CONSOLA_US);
+    planificador_periodica(&plan, "cpu", tarea_cpu_fn, NULL, 2, PERIODO_CPU_MS * 1000u);
+
+    // Secciones medidas (sin efecto si el perfil está deshabilitado)
+    PERFIL_REGISTRAR(perfil_timer_irq);
+    PERFIL_REGISTRAR(perfil_udp_rx_irq);
+    PERFIL_REGISTRAR(perfil_poll);
+    PERFIL_REGISTRAR(perfil_leer_dedos);
+    PERFIL_REGISTRAR(perfil_envio);
+
+    // El muestreo arranca antes que la red: las muestras se acumulan en el historial
+    bool guante_ok = guante_init();
+    arranque_marcar("guante");
 
-    if (cyw43_arch_wifi_connect_timeout_ms(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK, 15000)) {
-        printf("Fallo conexion WiFi\n");
-        return 1;
+    // --- CONFIGURACIÓN DEL TIMER (IRQ) ---
+    // Configura una interrupción por hardware cada PERIODO_MUESTREO_US
+    struct repeating_timer timer;
+    add_repeating_timer_us(-PERIODO_MUESTREO_US, muestreo_timer_callback, NULL, &timer);
+    arranque_marcar("muestreo");
+
+    if (cyw43_arch_init()) {
+        // Sin chip Wi-Fi no hay nada que hacer: reiniciar en lugar de quedar muerto
+        printf("Fallo cyw43, reiniciando\n");
+        watchdog_reboot(0, 0, 100);
+        while (1) tight_loop_contents();
     }
-    printf("WiFi Conectado.\n");
+    cyw43_wifi_pm(&cyw43_state, CYW43_NO_POWERSAVE_MODE);
+    cyw43_arch_enable_sta_mode();
+    arranque_marcar("cyw43");
 
-    if (!guante_init()) printf("Error Guante MUX/ADC\n");
+    // Conexión asíncrona: la asociación avanza en segundo plano
+    conexion_init(&wifi, WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK);
+    conexion_usar_ip_cache(&wifi, IP_CACHE_HABILITADA);
+    conexion_tick(&wifi);
+    arranque_marcar("wifi_async");
 
     udp_ready = udp_client_connect();
+    arranque_marcar("udp");
 
-    // --- CONFIGURACIÓN DEL TIMER (IRQ) ---
-    // Configura una interrupción por hardware cada 250 ms
-    struct repeating_timer timer;
-    add_repeating_timer_ms(-250, send_timer_callback, NULL, &timer);
+    // Sin host USB (batería) no se espera; con host, hasta que abra la consola
+    arranque_esperar_usb(USB_ESPERA_MAX_MS);
+    arranque_marcar("usb");
+
+    printf("=== GUANTE (CLIENTE): Arq. Polling + IRQ ===\n");
+    if (!guante_ok) printf("Error Guante MUX/ADC\n");
+    arranque_imprimir();
 
-    char buffer_trama[64];
+    // Nada bloquea a partir de aquí: el watchdog se refresca en cada vuelta
+    watchdog_enable(WATCHDOG_TIMEOUT_MS, true);
+    arranque_marcar("loop");
+    reposo_init(&reposo);
 
-    // --- LOOP PRINCIPAL (POLLING) ---
+    // --- LOOP PRINCIPAL (PLANIFICADOR) ---
     while (1) {
-        // 1. Polling de la pila de red (necesario para lwIP NO_SYS)
-        cyw43_arch_poll();
-
-        // 2. Polling de la Bandera de Interrupción
-        if (flag_timer_send) {
-            // Bajamos la bandera inmediatamente para no re-entrar
-            flag_timer_send = false; 
-
-            // Ejecutamos la lógica "pesada" fuera de la interrupción
-            uint8_t dedos[GUANTE_NUM_DEDOS];
-            guante_leer_dedos(dedos);
-
-            snprintf(buffer_trama, sizeof(buffer_trama),
-                     "H,%d,%d,%d,%d,%d",
-                     dedos[4], dedos[3], dedos[2], dedos[0], dedos[1]);
-
-            send_string(buffer_trama);
-            
-            tx_packet_count++;
-            printf("TX[%lu]: %s\n", tx_packet_count, buffer_trama);
+        watchdog_update();
+
+        // Polling de la pila de red (no-op con threadsafe_background; necesario con la variante poll)
+        {
+            PERFIL_SONDA(perfil_poll);
+            cyw43_arch_poll();
         }
-        
+
+        // Una tarea por vuelta: tras cada una se vuelve a elegir por prioridad
+        if (planificador_ejecutar(&plan)) continue;
+
+        // Sin tareas listas: dormir hasta la próxima activación o IRQ
+        reposo_esperar(&reposo, make_timeout_time_us(planificador_espera_us(&plan)));
     }
 }
@@ -0,0 +1,79 @@
+/**
+ * @file arranque.c
+ * @brief Implementación de la traza de arranque y la espera condicional del USB.
+ */
+
+#include "arranque.h"
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "pico/cyw43_arch.h"
+#include "tusb.h"
+
+/** Nombre de cada fase registrada. */
+static const char *fases[ARRANQUE_MAX_FASES];
+/** Instante de cada fase en µs desde el reset. */
+static uint32_t t_fases_us[ARRANQUE_MAX_FASES];
+/** Número de fases registradas. */
+static uint32_t num_fases = 0;
+/** true tras arranque_imprimir(): las nuevas marcas se imprimen al momento. */
+static bool en_vivo = false;
+
+/**
+ * @brief Imprime una fase con su instante y el tiempo desde la anterior.
+ * @param i Índice de la fase.
+ */
+static void imprimir_fase(uint32_t i) {
+    uint32_t delta = i ? t_fases_us[i] - t_fases_us[i - 1] : t_fases_us[i];
+    printf("[BOOT] %-14s t=%8luus (+%luus)\n", fases[i], t_fases_us[i], delta);
+}
+
+/**
+ * @brief Registra una fase del arranque con el instante actual.
+ * @param fase Nombre de la fase (debe ser un literal o tener vida estática).
+ */
+void arranque_marcar(const char *fase) {
+    if (num_fases >= ARRANQUE_MAX_FASES) return;
+    fases[num_fases] = fase;
+    t_fases_us[num_fases] = time_us_32();
+    if (en_vivo) imprimir_fase(num_fases);
+    num_fases++;
+}
+
+/**
+ * @brief Imprime las fases registradas y pasa a imprimir las siguientes al marcarlas.
+ */
+void arranque_imprimir(void) {
+    for (uint32_t i = 0; i < num_fases; i++) imprimir_fase(i);
+    en_vivo = true;
+}
+
+/**
+ * @brief Espera a que el host abra la consola USB, solo si un host está enumerando el dispositivo.
+ * @param timeout_ms Espera máxima a la consola con el host enumerado (ms).
+ * @return true si la consola USB está abierta.
+ */
+bool arranque_esperar_usb(uint32_t timeout_ms) {
+    if (!cyw43_arch_gpio_get(CYW43_WL_GPIO_VBUS_PIN)) {
+        arranque_marcar("usb_sin_vbus");
+        return false;
+    }
+
+    // VBUS solo dice que hay alimentación: un cargador no enumera nunca
+    absolute_time_t fin = make_timeout_time_ms(ARRANQUE_USB_ENUMERACION_MS);
+    while (!tud_mounted() && absolute_time_diff_us(fin, get_absolute_time()) < 0) {
+        sleep_ms(10);
+    }
+    if (!tud_mounted()) {
+        arranque_marcar("usb_sin_host");
+        return false;
+    }
+    arranque_marcar("usb_montado");
+
+    fin = make_timeout_time_ms(timeout_ms);
+    while (!stdio_usb_connected() && absolute_time_diff_us(fin, get_absolute_time()) < 0) {
+        sleep_ms(10);
+    }
+    return stdio_usb_connected();
+}
@@ -0,0 +1,52 @@
+/**
+ * @file arranque.h
+ * @brief Traza de la línea de tiempo de arranque y espera condicional del USB.
+ *
+ * Cada fase se marca con su instante desde el reset. Las marcas previas a que
+ * haya consola se guardan y se imprimen juntas con arranque_imprimir(); las
+ * posteriores se imprimen en el momento.
+ */
+
+#ifndef ARRANQUE_H
+#define ARRANQUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Máximo de fases registradas. */
+#define ARRANQUE_MAX_FASES 16
+/**
+ * Espera máxima a que un host empiece a enumerar el dispositivo (ms).
+ *
+ * Un PC enumera en unas decenas de ms desde que ve el dispositivo; un
+ * cargador o una batería externa con VBUS nunca lo hace.
+ */
+#define ARRANQUE_USB_ENUMERACION_MS 300
+
+/**
+ * @brief Registra una fase del arranque con el instante actual.
+ * @param fase Nombre de la fase (debe ser un literal o tener vida estática).
+ */
+void arranque_marcar(const char *fase);
+
+/**
+ * @brief Imprime las fases registradas y pasa a imprimir las siguientes al marcarlas.
+ */
+void arranque_imprimir(void);
+
+/**
+ * @brief Espera a que el host abra la consola USB, solo si un host está enumerando el dispositivo.
+ *
+ * VBUS solo filtra: sin él (batería) retorna en el acto. Con VBUS espera como
+ * mucho ARRANQUE_USB_ENUMERACION_MS a que el host configure el dispositivo
+ * (tud_mounted()); si no lo hace es un cargador y tampoco espera. Solo con el
+ * dispositivo montado espera a que se abra la consola. El camino tomado queda
+ * en la traza de arranque (`usb_sin_vbus`, `usb_sin_host`, `usb_montado`).
+ * Requiere cyw43_arch_init(), porque en la Pico W VBUS se lee por el chip Wi-Fi.
+ *
+ * @param timeout_ms Espera máxima a la consola con el host enumerado (ms).
+ * @return true si la consola USB está abierta.
+ */
+bool arranque_esperar_usb(uint32_t timeout_ms);
+
+#endif /* ARRANQUE_H */
@@ -0,0 +1,212 @@
+/**
+ * @file conexion.c
+ * @brief Implementación del gestor asíncrono de la conexión Wi-Fi.
+ *
+ * Usa cyw43_arch_wifi_connect_async y el estado del enlace de cyw43 en lugar
+ * de la conexión bloqueante, para que el main (y el watchdog) sigan corriendo
+ * durante la asociación y los cortes.
+ */
+
+#include "conexion.h"
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/netif.h"
+#include "lwip/dhcp.h"
+
+#include "lib/ipcache/ipcache.h"
+
+/** Nombres de los estados para los logs. */
+static const char *const nombres_estado[] = { "desconectado", "conectando", "conectado" };
+
+/**
+ * @brief Milisegundos desde el arranque.
+ * @return Tiempo actual en ms.
+ */
+static uint32_t ahora_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+/**
+ * @brief Aplica la IP en caché a la netif STA si hay una válida.
+ * @return true si se aplicó.
+ */
+static bool aplicar_ip_cache(void) {
+    ipcache_t cfg;
+    if (!ipcache_leer(&cfg)) return false;
+
+    ip4_addr_t ip, mascara, puerta;
+    ip4_addr_set_u32(&ip, cfg.ip);
+    ip4_addr_set_u32(&mascara, cfg.mascara);
+    ip4_addr_set_u32(&puerta, cfg.puerta);
+    cyw43_arch_lwip_begin();
+    netif_set_addr(&cyw43_state.netif[CYW43_ITF_STA], &ip, &mascara, &puerta);
+    cyw43_arch_lwip_end();
+    return true;
+}
+
+/**
+ * @brief Guarda en caché la configuración IP actual de la netif STA (obtenida por DHCP).
+ */
+static void guardar_ip_cache(void) {
+    const struct netif *n = &cyw43_state.netif[CYW43_ITF_STA];
+    ipcache_t cfg = {
+        .ip = ip4_addr_get_u32(netif_ip4_addr(n)),
+        .mascara = ip4_addr_get_u32(netif_ip4_netmask(n)),
+        .puerta = ip4_addr_get_u32(netif_ip4_gw(n)),
+    };
+    if (!ipcache_guardar(&cfg)) printf("[WIFI] no se pudo guardar la IP en caché\n");
+}
+
+/**
+ * @brief Indica si el enlace puede usarse con el estado cyw43 dado.
+ * @param c    Descriptor de la conexión.
+ * @param link Estado CYW43_LINK_* actual.
+ * @return true con IP de DHCP, o asociado con la IP en caché aplicada.
+ */
+static bool enlace_usable(const conexion_t *c, int link) {
+    return link == CYW43_LINK_UP || (c->ip_cache_aplicada && link == CYW43_LINK_NOIP);
+}
+
+/**
+ * @brief Programa el próximo intento tras un fallo y duplica el backoff.
+ * @param c     Descriptor de la conexión.
+ * @param ahora Instante actual en ms.
+ */
+static void programar_reintento(conexion_t *c, uint32_t ahora) {
+    c->estado = CONEXION_DESCONECTADO;
+    c->t_reintento_ms = ahora + c->backoff_ms;
+    c->backoff_ms *= 2;
+    if (c->backoff_ms > CONEXION_BACKOFF_MAX_MS) c->backoff_ms = CONEXION_BACKOFF_MAX_MS;
+}
+
+/**
+ * @brief Inicializa el gestor; el primer intento se lanza en el próximo tick.
+ * @param c        Descriptor a inicializar.
+ * @param ssid     SSID de la red.
+ * @param password Contraseña de la red.
+ * @param auth     Tipo de autenticación (CYW43_AUTH_*).
+ */
+void conexion_init(conexion_t *c, const char *ssid, const char *password, uint32_t auth) {
+    *c = (conexion_t){ 0 };
+    c->ssid = ssid;
+    c->password = password;
+    c->auth = auth;
+    c->estado = CONEXION_DESCONECTADO;
+    c->backoff_ms = CONEXION_BACKOFF_MIN_MS;
+    c->t_reintento_ms = c->t_corte_ms = ahora_ms();
+}
+
+/**
+ * @brief Habilita arrancar con la IP en caché.
+ * @param c         Descriptor de la conexión.
+ * @param habilitar true para usar la caché.
+ */
+void conexion_usar_ip_cache(conexion_t *c, bool habilitar) {
+    c->usar_ip_cache = habilitar;
+}
+
+/**
+ * @brief Avanza la máquina de estados sin bloquear.
+ * @param c Descriptor de la conexión.
+ * @return Evento ocurrido en esta vuelta.
+ */
+conexion_evento_t conexion_tick(conexion_t *c) {
+    uint32_t ahora = ahora_ms();
+    int link = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+    c->ultimo_estado_link = link;
+
+    switch (c->estado) {
+    case CONEXION_DESCONECTADO:
+        if ((int32_t)(ahora - c->t_reintento_ms) < 0) break;
+        c->intentos++;
+        c->t_intento_ms = ahora;
+        c->ip_cache_aplicada = false;
+        c->ip_cache_revisada = false;
+        if (cyw43_arch_wifi_connect_async(c->ssid, c->password, c->auth) == 0) {
+            c->estado = CONEXION_CONECTANDO;
+        } else {
+            c->fallos++;
+            programar_reintento(c, ahora);
+        }
+        break;
+
+    case CONEXION_CONECTANDO:
+        // Asociado pero sin IP: no esperar a DHCP si hay una IP en caché
+        if (link == CYW43_LINK_NOIP && c->usar_ip_cache && !c->ip_cache_aplicada) {
+            c->ip_cache_aplicada = aplicar_ip_cache();
+        }
+        if (enlace_usable(c, link)) {
+            c->estado = CONEXION_CONECTADO;
+            c->conexiones++;
+            c->backoff_ms = CONEXION_BACKOFF_MIN_MS;
+            c->ultima_reconexion_ms = ahora - c->t_corte_ms;
+            if (c->ultima_reconexion_ms > c->max_reconexion_ms) c->max_reconexion_ms = c->ultima_reconexion_ms;
+            c->total_sin_red_ms += c->ultima_reconexion_ms;
+            c->ip_anunciada = ip4_addr_get_u32(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA]));
+            return CONEXION_EVENTO_CONECTADO;
+        }
+        // Error definitivo (red no encontrada, clave, ...) o intento vencido
+        if (link < 0 || ahora - c->t_intento_ms > CONEXION_TIMEOUT_MS) {
+            c->fallos++;
+            cyw43_arch_lwip_begin();
+            cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+            cyw43_arch_lwip_end();
+            programar_reintento(c, ahora);
+        }
+        break;
+
+    case CONEXION_CONECTADO:
+        if (!enlace_usable(c, link)) {
+            // Soltar la asociación anterior: puede seguir viva y hacer que el
+            // driver rechace el reintento o informe un estado viejo
+            cyw43_arch_lwip_begin();
+            cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+            cyw43_arch_lwip_end();
+            c->caidas++;
+            c->t_corte_ms = ahora;
+            c->backoff_ms = CONEXION_BACKOFF_MIN_MS;
+            c->estado = CONEXION_DESCONECTADO;
+            c->t_reintento_ms = ahora; // Reintento inmediato
+            return CONEXION_EVENTO_CAIDA;
+        }
+        // Con la IP en caché la netif ya tiene dirección (LINK_UP) antes de que
+        // DHCP responda: solo una concesión real confirma o cambia la caché
+        if (dhcp_supplied_address(&cyw43_state.netif[CYW43_ITF_STA])) {
+            if (c->usar_ip_cache && !c->ip_cache_revisada) {
+                c->ip_cache_revisada = true;
+                guardar_ip_cache();
+            }
+            uint32_t ip = ip4_addr_get_u32(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA]));
+            if (ip != c->ip_anunciada) {
+                c->ip_anunciada = ip;
+                c->cambios_ip++;
+                return CONEXION_EVENTO_IP_CAMBIADA;
+            }
+        }
+        break;
+    }
+    return CONEXION_EVENTO_NINGUNO;
+}
+
+/**
+ * @brief Indica si el enlace está arriba y con IP.
+ * @param c Descriptor de la conexión.
+ * @return true si se puede usar la red.
+ */
+bool conexion_lista(const conexion_t *c) {
+    return c->estado == CONEXION_CONECTADO;
+}
+
+/**
+ * @brief Imprime el estado y los contadores de la conexión.
+ * @param c Descriptor de la conexión.
+ */
+void conexion_imprimir(const conexion_t *c) {
+    printf("[WIFI] estado=%s link=%d ip_cache=%d intentos=%lu fallos=%lu conexiones=%lu caidas=%lu "
+           "cambios_ip=%lu ultima_reconexion=%lums max_reconexion=%lums sin_red=%lums\n",
+           nombres_estado[c->estado], c->ultimo_estado_link, c->ip_cache_aplicada, c->intentos, c->fallos,
+           c->conexiones, c->caidas, c->cambios_ip, c->ultima_reconexion_ms, c->max_reconexion_ms,
+           c->total_sin_red_ms);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file conexion.h
+ * @brief Gestor asíncrono de la conexión Wi-Fi (STA) compartido por guante y mano.
+ *
+ * Sustituye a cyw43_arch_wifi_connect_timeout_ms: nunca bloquea, reintenta con
+ * backoff exponencial, detecta caídas del enlace y lleva contadores de cortes.
+ * Opcionalmente arranca con la IP de la sesión anterior (lib/ipcache).
+ */
+
+#ifndef CONEXION_H
+#define CONEXION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Tiempo máximo de un intento de asociación + DHCP (ms). */
+#define CONEXION_TIMEOUT_MS      10000
+/** Espera inicial entre intentos fallidos (ms). */
+#define CONEXION_BACKOFF_MIN_MS  250
+/** Espera máxima entre intentos fallidos (ms). */
+#define CONEXION_BACKOFF_MAX_MS  8000
+
+/**
+ * @brief Estado de la máquina de conexión.
+ */
+typedef enum {
+    CONEXION_DESCONECTADO,  /**< Sin enlace; se intentará conectar en cuanto venza el backoff. */
+    CONEXION_CONECTANDO,    /**< Intento asíncrono en curso (asociación o DHCP). */
+    CONEXION_CONECTADO      /**< Enlace arriba y con IP. */
+} conexion_estado_t;
+
+/**
+ * @brief Evento que devuelve conexion_tick() en la vuelta en que ocurre.
+ */
+typedef enum {
+    CONEXION_EVENTO_NINGUNO,    /**< Sin cambios. */
+    CONEXION_EVENTO_CONECTADO,  /**< El enlace acaba de quedar listo (con IP). */
+    CONEXION_EVENTO_CAIDA,      /**< El enlace acaba de caerse. */
+    CONEXION_EVENTO_IP_CAMBIADA /**< DHCP asignó una IP distinta de la anunciada al conectar (p. ej. la de caché). */
+} conexion_evento_t;
+
+/**
+ * @brief Descriptor de la conexión y sus contadores.
+ */
+typedef struct {
+    const char *ssid;               /**< SSID de la red. */
+    const char *password;           /**< Contraseña de la red. */
+    uint32_t auth;                  /**< Tipo de autenticación (CYW43_AUTH_*). */
+
+    conexion_estado_t estado;       /**< Estado actual. */
+    uint32_t t_intento_ms;          /**< Inicio del intento en curso. */
+    uint32_t t_reintento_ms;        /**< Instante del próximo intento. */
+    uint32_t t_corte_ms;            /**< Inicio del corte actual (arranque o caída). */
+    uint32_t backoff_ms;            /**< Espera actual entre intentos. */
+    int      ultimo_estado_link;    /**< Último CYW43_LINK_* observado. */
+    bool     usar_ip_cache;         /**< Usar la IP en caché mientras DHCP confirma. */
+    bool     ip_cache_aplicada;     /**< El intento en curso usa la IP en caché. */
+    bool     ip_cache_revisada;     /**< La IP de DHCP de este enlace ya se comparó con la caché. */
+    uint32_t ip_anunciada;          /**< IP de la netif en el último evento CONECTADO o IP_CAMBIADA. */
+
+    uint32_t intentos;              /**< Intentos de conexión lanzados. */
+    uint32_t fallos;                /**< Intentos fallidos o vencidos. */
+    uint32_t conexiones;            /**< Conexiones completadas. */
+    uint32_t caidas;                /**< Caídas del enlace estando conectado. */
+    uint32_t cambios_ip;            /**< Concesiones DHCP con una IP distinta de la anunciada. */
+    uint32_t ultima_reconexion_ms;  /**< Duración del último corte hasta volver a tener IP. */
+    uint32_t max_reconexion_ms;     /**< Mayor duración de corte observada. */
+    uint32_t total_sin_red_ms;      /**< Tiempo total sin red (cortes cerrados). */
+} conexion_t;
+
+/**
+ * @brief Inicializa el gestor; el primer intento se lanza en el próximo tick.
+ * @param c        Descriptor a inicializar.
+ * @param ssid     SSID de la red.
+ * @param password Contraseña de la red.
+ * @param auth     Tipo de autenticación (CYW43_AUTH_*).
+ */
+void conexion_init(conexion_t *c, const char *ssid, const char *password, uint32_t auth);
+
+/**
+ * @brief Habilita arrancar con la IP en caché.
+ *
+ * Al asociarse se aplica la última IP obtenida por DHCP y el enlace se da por
+ * listo sin esperar a DHCP, que sigue en segundo plano. La caché solo se
+ * reescribe cuando DHCP concede la dirección; si es otra, conexion_tick()
+ * devuelve CONEXION_EVENTO_IP_CAMBIADA para que se rehaga lo que depende de ella.
+ *
+ * @param c         Descriptor de la conexión.
+ * @param habilitar true para usar la caché.
+ */
+void conexion_usar_ip_cache(conexion_t *c, bool habilitar);
+
+/**
+ * @brief Avanza la máquina de estados sin bloquear (llamar en cada vuelta del main).
+ * @param c Descriptor de la conexión.
+ * @return Evento ocurrido en esta vuelta.
+ */
+conexion_evento_t conexion_tick(conexion_t *c);
+
+/**
+ * @brief Indica si el enlace está arriba y con IP.
+ * @param c Descriptor de la conexión.
+ * @return true si se puede usar la red.
+ */
+bool conexion_lista(const conexion_t *c);
+
+/**
+ * @brief Imprime el estado y los contadores de la conexión.
+ * @param c Descriptor de la conexión.
+ */
+void conexion_imprimir(const conexion_t *c);
+
+#endif /* CONEXION_H */
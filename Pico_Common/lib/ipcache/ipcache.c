@@ -0,0 +1,75 @@
+/**
+ * @file ipcache.c
+ * @brief Implementación de la caché en flash de la configuración IP.
+ */
+
+#include "ipcache.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+
+/** Marca de registro válido ("IPC1"). */
+#define IPCACHE_MAGIA    0x31435049u
+/** Offset del sector usado, relativo al inicio de la flash. */
+#define IPCACHE_OFFSET   (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+/** Tiempo máximo de espera para acceder a la flash (ms). */
+#define IPCACHE_TIMEOUT_MS 100
+
+/**
+ * @brief Registro tal como se guarda en flash.
+ */
+typedef struct {
+    uint32_t magia;     /**< IPCACHE_MAGIA si el registro es válido. */
+    ipcache_t cfg;      /**< Configuración guardada. */
+    uint32_t control;   /**< XOR de los campos de cfg y la magia. */
+} ipcache_registro_t;
+
+/**
+ * @brief Calcula el valor de control de un registro.
+ * @param r Registro.
+ * @return XOR de la magia y los campos de la configuración.
+ */
+static uint32_t control(const ipcache_registro_t *r) {
+    return r->magia ^ r->cfg.ip ^ r->cfg.mascara ^ r->cfg.puerta;
+}
+
+/**
+ * @brief Borra el sector y programa la primera página (se ejecuta con la flash en exclusiva).
+ * @param param Página de FLASH_PAGE_SIZE bytes a programar.
+ */
+static void escribir_sector(void *param) {
+    flash_range_erase(IPCACHE_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(IPCACHE_OFFSET, (const uint8_t *)param, FLASH_PAGE_SIZE);
+}
+
+/**
+ * @brief Lee la configuración guardada.
+ * @param out Configuración leída.
+ * @return true si hay una configuración válida.
+ */
+bool ipcache_leer(ipcache_t *out) {
+    const ipcache_registro_t *r = (const ipcache_registro_t *)(XIP_BASE + IPCACHE_OFFSET);
+    if (r->magia != IPCACHE_MAGIA || r->control != control(r) || r->cfg.ip == 0) return false;
+    *out = r->cfg;
+    return true;
+}
+
+/**
+ * @brief Guarda la configuración si difiere de la almacenada.
+ * @param cfg Configuración a guardar.
+ * @return true si queda guardada.
+ */
+bool ipcache_guardar(const ipcache_t *cfg) {
+    ipcache_t actual;
+    if (ipcache_leer(&actual) && memcmp(&actual, cfg, sizeof(actual)) == 0) return true;
+
+    static uint8_t pagina[FLASH_PAGE_SIZE];
+    memset(pagina, 0xFF, sizeof(pagina));
+    ipcache_registro_t r = { .magia = IPCACHE_MAGIA, .cfg = *cfg };
+    r.control = control(&r);
+    memcpy(pagina, &r, sizeof(r));
+
+    return flash_safe_execute(escribir_sector, pagina, IPCACHE_TIMEOUT_MS) == PICO_OK;
+}
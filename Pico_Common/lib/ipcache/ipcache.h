@@ -0,0 +1,42 @@
+/**
+ * @file ipcache.h
+ * @brief Caché en flash de la última configuración IP obtenida por DHCP.
+ *
+ * Permite arrancar con la IP de la sesión anterior mientras DHCP confirma en
+ * segundo plano. Ocupa el último sector de la flash.
+ */
+
+#ifndef IPCACHE_H
+#define IPCACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Configuración IP guardada (direcciones en orden de red, como lwIP).
+ */
+typedef struct {
+    uint32_t ip;       /**< Dirección IP. */
+    uint32_t mascara;  /**< Máscara de subred. */
+    uint32_t puerta;   /**< Puerta de enlace. */
+} ipcache_t;
+
+/**
+ * @brief Lee la configuración guardada.
+ * @param out Configuración leída.
+ * @return true si hay una configuración válida.
+ */
+bool ipcache_leer(ipcache_t *out);
+
+/**
+ * @brief Guarda la configuración si difiere de la almacenada.
+ *
+ * Borra y programa el sector con las interrupciones deshabilitadas (unas
+ * decenas de ms), así que solo debe llamarse cuando la IP cambia.
+ *
+ * @param cfg Configuración a guardar.
+ * @return true si queda guardada.
+ */
+bool ipcache_guardar(const ipcache_t *cfg);
+
+#endif /* IPCACHE_H */
@@ -0,0 +1,102 @@
+/**
+ * @file memoria.c
+ * @brief Pintado de pilas e informe de uso de memoria.
+ *
+ * Los límites de las pilas salen del linker script del SDK: la del núcleo 0
+ * vive en SCRATCH_Y y la del núcleo 1 en SCRATCH_X, ambas crecen hacia abajo.
+ */
+
+#include "memoria.h"
+
+#include <stdio.h>
+#include <stddef.h>
+#include <malloc.h>
+#include "hardware/sync.h"
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+
+/** @brief Límites de las pilas y del heap definidos por el linker script. */
+extern uint32_t __StackBottom[], __StackTop[];
+extern uint32_t __StackOneBottom[], __StackOneTop[];
+extern char __end__[], __StackLimit[];
+
+#if MEMP_STATS
+/** @brief Nombres de los pools de lwIP, en el orden de memp_t. */
+static const char *const nombres_memp[] = {
+#define LWIP_MEMPOOL(name, num, size, desc) #name,
+#include "lwip/priv/memp_std.h"
+};
+#endif
+
+/** @brief Palabras bajo el puntero de pila que no se pintan (margen del propio marco). */
+#define MARGEN_PILA_PALABRAS 16
+
+/**
+ * @brief Pinta la pila libre del núcleo 0 y la del núcleo 1 con MEMORIA_PATRON.
+ *
+ * Sin llamadas entre la lectura de sp y el pintado: un marco nuevo quedaría
+ * por debajo de sp y se pisaría a sí mismo.
+ */
+void memoria_pintar_pilas(void) {
+    uint32_t *sp;
+    __asm volatile ("mov %0, sp" : "=r"(sp));
+
+    // Sin IRQ: ninguna puede tener un marco vivo por debajo de sp mientras se pinta
+    uint32_t estado = save_and_disable_interrupts();
+    for (uint32_t *p = __StackBottom; p < sp - MARGEN_PILA_PALABRAS; p++) *p = MEMORIA_PATRON;
+    restore_interrupts(estado);
+
+    // El núcleo 1 no corre todavía: se pinta entera
+    for (uint32_t *p = __StackOneBottom; p < __StackOneTop; p++) *p = MEMORIA_PATRON;
+}
+
+/**
+ * @brief Uso máximo de la pila de un núcleo desde que se pintó.
+ * @param nucleo     Núcleo (0 o 1).
+ * @param[out] total Tamaño de la pila en bytes (puede ser NULL).
+ * @return Bytes usados como máximo.
+ */
+uint32_t memoria_pila_max(uint32_t nucleo, uint32_t *total) {
+    uint32_t *fondo = nucleo ? __StackOneBottom : __StackBottom;
+    uint32_t *tope = nucleo ? __StackOneTop : __StackTop;
+    if (total) *total = (uint32_t)((tope - fondo) * sizeof(uint32_t));
+
+    // La pila crece hacia abajo: la primera palabra modificada desde el fondo marca el máximo
+    uint32_t *p = fondo;
+    while (p < tope && *p == MEMORIA_PATRON) p++;
+    return (uint32_t)((tope - p) * sizeof(uint32_t));
+}
+
+/**
+ * @brief Imprime las marcas de agua de las pilas, el heap de C, el heap de lwIP y los pools.
+ *
+ * Las marcas de agua y los picos son máximos desde el arranque: no se reinician.
+ */
+void memoria_imprimir(void) {
+    uint32_t total0, total1;
+    uint32_t max0 = memoria_pila_max(0, &total0);
+    uint32_t max1 = memoria_pila_max(1, &total1);
+    struct mallinfo mi = mallinfo();
+
+    printf("[MEM] pila0=%lu/%luB pila1=%lu/%luB heap_c=%lu/%luB",
+           (unsigned long)max0, (unsigned long)total0,
+           (unsigned long)max1, (unsigned long)total1,
+           (unsigned long)mi.arena, (unsigned long)(__StackLimit - __end__));
+#if MEM_STATS
+    printf(" lwip_heap=%u/%uB err=%u", (unsigned)lwip_stats.mem.max,
+           (unsigned)lwip_stats.mem.avail, (unsigned)lwip_stats.mem.err);
+#endif
+    printf("\n");
+
+#if MEMP_STATS
+    // max/capacidad de cada pool, con los fallos de reserva si los hubo
+    printf("[MEMP]");
+    for (uint32_t i = 0; i < MEMP_MAX; i++) {
+        const struct stats_mem *m = lwip_stats.memp[i];
+        if (!m) continue;
+        printf(" %s=%u/%u", nombres_memp[i], (unsigned)m->max, (unsigned)m->avail);
+        if (m->err) printf("(err %u)", (unsigned)m->err);
+    }
+    printf("\n");
+#endif
+}
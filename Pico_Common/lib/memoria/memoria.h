@@ -0,0 +1,43 @@
+/**
+ * @file memoria.h
+ * @brief Marcas de agua de las pilas y picos de memoria de lwIP y del heap de C.
+ *
+ * memoria_pintar_pilas() rellena al arrancar las pilas de ambos núcleos con un
+ * patrón; la parte de cada pila que ya no lo conserva es su uso máximo. Junto
+ * con los picos del heap y de los pools de lwIP (MEM_STATS/MEMP_STATS en
+ * lwipopts.h) sirve para ajustar MEM_SIZE, los pools y los buffers en pila
+ * con datos en lugar de a ojo. La huella estática por módulo la da el target
+ * `<firmware>_huella` (tools/huella.py).
+ */
+
+#ifndef MEMORIA_H
+#define MEMORIA_H
+
+#include <stdint.h>
+
+/** Patrón con el que se pintan las pilas. */
+#define MEMORIA_PATRON 0xA5A5A5A5u
+
+/**
+ * @brief Pinta la pila libre del núcleo 0 y la del núcleo 1 con MEMORIA_PATRON.
+ *
+ * Llamar lo primero en main() y antes de lanzar el núcleo 1. Pinta la pila
+ * del núcleo 0 por debajo del puntero de pila actual con las interrupciones
+ * bloqueadas.
+ */
+void memoria_pintar_pilas(void);
+
+/**
+ * @brief Uso máximo de la pila de un núcleo desde que se pintó.
+ * @param nucleo     Núcleo (0 o 1).
+ * @param[out] total Tamaño de la pila en bytes (puede ser NULL).
+ * @return Bytes usados como máximo.
+ */
+uint32_t memoria_pila_max(uint32_t nucleo, uint32_t *total);
+
+/**
+ * @brief Imprime las marcas de agua de las pilas, el heap de C, el heap de lwIP y los pools.
+ */
+void memoria_imprimir(void);
+
+#endif /* MEMORIA_H */
@@ -0,0 +1,70 @@
+/**
+ * @file perfil.c
+ * @brief Registro y volcado de las secciones medidas.
+ *
+ * Las sondas solo tocan su propia sección; este módulo guarda la lista de
+ * secciones y las vuelca por la consola.
+ */
+
+#include "perfil.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "hardware/sync.h"
+
+/** @brief Secciones registradas. */
+static perfil_seccion_t *secciones[PERFIL_MAX_SECCIONES];
+/** @brief Número de secciones registradas. */
+static uint32_t num_secciones = 0;
+
+/**
+ * @brief Añade una sección a la lista que vuelca perfil_imprimir().
+ * @param s Sección con vida estática.
+ * @return true si se registró, false si no hay hueco.
+ */
+bool perfil_registrar(perfil_seccion_t *s) {
+    if (num_secciones >= PERFIL_MAX_SECCIONES) return false;
+    secciones[num_secciones++] = s;
+    return true;
+}
+
+/**
+ * @brief Imprime mínimo, media, máximo e histograma de cada sección y las reinicia.
+ *
+ * Cada sección se copia y reinicia con las interrupciones bloqueadas, porque
+ * las de los callbacks se actualizan desde IRQ. El printf va fuera de esa zona.
+ */
+void perfil_imprimir(void) {
+#if PERFIL_HABILITADO
+    for (uint32_t i = 0; i < num_secciones; i++) {
+        perfil_seccion_t *s = secciones[i];
+        perfil_seccion_t c;
+
+        uint32_t estado = save_and_disable_interrupts();
+        c = *s;
+        memset(s->hist, 0, sizeof(s->hist));
+        s->pasadas = 0;
+        s->total_us = 0;
+        s->min_us = UINT32_MAX;
+        s->max_us = 0;
+        restore_interrupts(estado);
+
+        if (c.pasadas == 0) {
+            printf("[PERFIL] %-16s sin pasadas\n", c.nombre);
+            continue;
+        }
+        printf("[PERFIL] %-16s n=%lu min=%luus media=%luus max=%luus hist:",
+               c.nombre, (unsigned long)c.pasadas, (unsigned long)c.min_us,
+               (unsigned long)(c.total_us / c.pasadas), (unsigned long)c.max_us);
+        for (uint32_t b = 0; b < PERFIL_HIST_BINS; b++) {
+            if (!c.hist[b]) continue;
+            if (b <= 1) printf(" %lu=%lu", (unsigned long)b, (unsigned long)c.hist[b]);
+            else if (b == PERFIL_HIST_BINS - 1) printf(" >=%lu=%lu", 1ul << (b - 1), (unsigned long)c.hist[b]);
+            else printf(" %lu-%lu=%lu", 1ul << (b - 1), (1ul << b) - 1, (unsigned long)c.hist[b]);
+        }
+        printf("\n");
+    }
+#else
+    printf("[PERFIL] deshabilitado (compilar con CMAKE_BUILD_TYPE=Debug)\n");
+#endif
+}
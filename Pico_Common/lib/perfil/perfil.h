@@ -0,0 +1,116 @@
+/**
+ * @file perfil.h
+ * @brief Sondas de tiempo por sección (bucle principal y callbacks en IRQ).
+ *
+ * Cada sección acumula número de pasadas, mínimo, media, máximo e histograma
+ * log2 de su duración en µs. Una sonda mide desde su declaración hasta el
+ * final del bloque que la contiene, también si se sale con return:
+ *
+ * @code
+ * PERFIL_DEFINIR(perfil_poll, "cyw43_poll");   // a nivel de archivo
+ * PERFIL_REGISTRAR(perfil_poll);               // una vez, desde el main
+ * { PERFIL_SONDA(perfil_poll); cyw43_arch_poll(); }
+ * @endcode
+ *
+ * Con PERFIL_HABILITADO a 0 (builds Release) las macros no generan código y
+ * perfil_imprimir() solo avisa de que el perfil está deshabilitado.
+ */
+
+#ifndef PERFIL_H
+#define PERFIL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/timer.h"
+
+/**
+ * @brief 1 para compilar las sondas; lo fija el CMakeLists según el tipo de build.
+ */
+#ifndef PERFIL_HABILITADO
+#define PERFIL_HABILITADO 0
+#endif
+
+/** Máximo de secciones registradas. */
+#define PERFIL_MAX_SECCIONES 16
+
+/** Cubetas del histograma: 0 = 0 µs, i > 0 = [2^(i-1), 2^i) µs, la última abierta. */
+#define PERFIL_HIST_BINS 16
+
+/**
+ * @brief Estadísticas de una sección desde el último volcado.
+ *
+ * Cada sección se actualiza desde un único contexto (el main o una IRQ);
+ * perfil_imprimir() la copia y reinicia con las interrupciones bloqueadas.
+ */
+typedef struct {
+    const char *nombre;               /**< Nombre para los logs (literal). */
+    uint32_t pasadas;                 /**< Ejecuciones medidas. */
+    uint32_t min_us;                  /**< Menor duración. */
+    uint32_t max_us;                  /**< Mayor duración. */
+    uint64_t total_us;                /**< Suma de duraciones. */
+    uint32_t hist[PERFIL_HIST_BINS];  /**< Histograma log2 de duraciones. */
+} perfil_seccion_t;
+
+/**
+ * @brief Sonda en curso: sección e instante de entrada.
+ */
+typedef struct {
+    perfil_seccion_t *seccion; /**< Sección a la que se suma la medida. */
+    uint32_t t0_us;            /**< Instante de entrada (time_us_32). */
+} perfil_sonda_t;
+
+/**
+ * @brief Suma una duración a una sección.
+ * @param s     Sección.
+ * @param dt_us Duración en µs.
+ */
+static inline void perfil_sumar(perfil_seccion_t *s, uint32_t dt_us) {
+    uint32_t cubeta = dt_us ? 32u - (uint32_t)__builtin_clz(dt_us) : 0u;
+    if (cubeta >= PERFIL_HIST_BINS) cubeta = PERFIL_HIST_BINS - 1;
+    s->hist[cubeta]++;
+    s->pasadas++;
+    s->total_us += dt_us;
+    if (dt_us < s->min_us) s->min_us = dt_us;
+    if (dt_us > s->max_us) s->max_us = dt_us;
+}
+
+/**
+ * @brief Cierra una sonda al salir de su bloque (la llama el compilador).
+ * @param sonda Sonda que sale de ámbito.
+ */
+static inline void perfil_sonda_cerrar(perfil_sonda_t *sonda) {
+    perfil_sumar(sonda->seccion, time_us_32() - sonda->t0_us);
+}
+
+#define PERFIL_CONCAT_(a, b) a##b
+#define PERFIL_CONCAT(a, b)  PERFIL_CONCAT_(a, b)
+
+#if PERFIL_HABILITADO
+/** @brief Define una sección estática con su nombre. */
+#define PERFIL_DEFINIR(var, texto) \
+    static perfil_seccion_t var = { .nombre = (texto), .min_us = UINT32_MAX }
+/** @brief Añade la sección a los volcados (solo desde el main, antes de usarla). */
+#define PERFIL_REGISTRAR(var) perfil_registrar(&(var))
+/** @brief Mide desde aquí hasta el final del bloque actual. */
+#define PERFIL_SONDA(var) \
+    perfil_sonda_t PERFIL_CONCAT(perfil_sonda_, __LINE__) \
+        __attribute__((cleanup(perfil_sonda_cerrar))) = { &(var), time_us_32() }
+#else
+#define PERFIL_DEFINIR(var, texto) struct perfil_sin_uso_
+#define PERFIL_REGISTRAR(var)       ((void)0)
+#define PERFIL_SONDA(var)           ((void)0)
+#endif
+
+/**
+ * @brief Añade una sección a la lista que vuelca perfil_imprimir().
+ * @param s Sección con vida estática.
+ * @return true si se registró, false si no hay hueco.
+ */
+bool perfil_registrar(perfil_seccion_t *s);
+
+/**
+ * @brief Imprime mínimo, media, máximo e histograma de cada sección y las reinicia.
+ */
+void perfil_imprimir(void);
+
+#endif /* PERFIL_H */
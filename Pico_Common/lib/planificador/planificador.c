@@ -0,0 +1,217 @@
+/**
+ * @file planificador.c
+ * @brief Implementación del planificador cooperativo por plazos.
+ *
+ * Los instantes son µs de 32 bits y se comparan por diferencia con signo, así
+ * que soportan la vuelta del contador (~71 min) con periodos y plazos cortos.
+ */
+
+#include "planificador.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief Registra una tarea.
+ * @param p          Planificador.
+ * @param nombre     Nombre (literal).
+ * @param fn         Función de la tarea.
+ * @param ctx        Contexto de la función.
+ * @param prioridad  Prioridad (0 = más alta).
+ * @param periodo_us Periodo (0 = por evento).
+ * @param plazo_us   Plazo relativo a la activación.
+ * @return Identificador de la tarea, o -1 si no hay hueco.
+ */
+static int registrar(planificador_t *p, const char *nombre, tarea_fn_t fn, void *ctx,
+                     uint8_t prioridad, uint32_t periodo_us, uint32_t plazo_us) {
+    if (p->num_tareas >= PLANIFICADOR_MAX_TAREAS) return -1;
+
+    tarea_t *t = &p->tareas[p->num_tareas];
+    memset(t, 0, sizeof(*t));
+    t->nombre = nombre;
+    t->fn = fn;
+    t->ctx = ctx;
+    t->prioridad = prioridad;
+    t->periodo_us = periodo_us;
+    t->plazo_us = plazo_us;
+    if (periodo_us) {
+        t->armada = true;
+        t->t_activacion_us = p->reloj();
+    }
+    return (int)p->num_tareas++;
+}
+
+/**
+ * @brief Indica si una tarea está lista para ejecutarse.
+ * @param t     Tarea.
+ * @param ahora Instante actual.
+ * @return true si está señalada o su activación programada ya venció.
+ */
+static bool lista(const tarea_t *t, uint32_t ahora) {
+    return t->pendiente || (t->armada && (int32_t)(ahora - t->t_activacion_us) >= 0);
+}
+
+/**
+ * @brief Inicializa el planificador sin tareas.
+ * @param p     Planificador.
+ * @param reloj Reloj en µs.
+ */
+void planificador_init(planificador_t *p, planificador_reloj_t reloj) {
+    memset(p, 0, sizeof(*p));
+    p->reloj = reloj;
+    p->t_ventana_us = reloj();
+}
+
+/**
+ * @brief Registra una tarea periódica; la primera activación es inmediata.
+ * @param p          Planificador.
+ * @param nombre     Nombre (literal).
+ * @param fn         Función de la tarea.
+ * @param ctx        Contexto de la función.
+ * @param prioridad  Prioridad (0 = más alta).
+ * @param periodo_us Periodo; también es su plazo.
+ * @return Identificador de la tarea, o -1 si no hay hueco.
+ */
+int planificador_periodica(planificador_t *p, const char *nombre, tarea_fn_t fn, void *ctx,
+                           uint8_t prioridad, uint32_t periodo_us) {
+    if (periodo_us == 0) return -1;
+    return registrar(p, nombre, fn, ctx, prioridad, periodo_us, periodo_us);
+}
+
+/**
+ * @brief Registra una tarea por evento.
+ * @param p         Planificador.
+ * @param nombre    Nombre (literal).
+ * @param fn        Función de la tarea.
+ * @param ctx       Contexto de la función.
+ * @param prioridad Prioridad (0 = más alta).
+ * @param plazo_us  Plazo desde la señal o la activación programada.
+ * @return Identificador de la tarea, o -1 si no hay hueco.
+ */
+int planificador_evento(planificador_t *p, const char *nombre, tarea_fn_t fn, void *ctx,
+                        uint8_t prioridad, uint32_t plazo_us) {
+    return registrar(p, nombre, fn, ctx, prioridad, 0, plazo_us);
+}
+
+/**
+ * @brief Señala una tarea para que se ejecute cuanto antes (apto para IRQ).
+ * @param p  Planificador.
+ * @param id Tarea.
+ */
+void planificador_senalar(planificador_t *p, int id) {
+    if (id < 0 || (uint32_t)id >= p->num_tareas) return;
+    tarea_t *t = &p->tareas[id];
+    t->t_senal_us = p->reloj();
+    t->pendiente = true; // Después del instante: el main nunca ve una señal sin él
+}
+
+/**
+ * @brief Programa una activación de la tarea en un instante (solo desde el bucle principal).
+ * @param p    Planificador.
+ * @param id   Tarea.
+ * @param t_us Instante de activación.
+ */
+void planificador_programar(planificador_t *p, int id, uint32_t t_us) {
+    if (id < 0 || (uint32_t)id >= p->num_tareas) return;
+    p->tareas[id].t_activacion_us = t_us;
+    p->tareas[id].armada = true;
+}
+
+/**
+ * @brief Ejecuta hasta terminar la tarea lista de mayor prioridad.
+ *
+ * A igual prioridad gana la registrada antes. Una tarea periódica que se
+ * retrasa más de un periodo no acumula ejecuciones: se saltan las
+ * activaciones vencidas y se cuentan en periodos_saltados.
+ *
+ * @param p Planificador.
+ * @return true si ejecutó una tarea, false si no había ninguna lista.
+ */
+bool planificador_ejecutar(planificador_t *p) {
+    uint32_t ahora = p->reloj();
+    tarea_t *t = NULL;
+    for (uint32_t i = 0; i < p->num_tareas; i++) {
+        tarea_t *c = &p->tareas[i];
+        if (lista(c, ahora) && (!t || c->prioridad < t->prioridad)) t = c;
+    }
+    if (!t) return false;
+
+    // Instante de activación: el más antiguo entre la señal y la activación programada
+    bool senal = t->pendiente;
+    uint32_t t_act = ahora;
+    if (senal) {
+        t->pendiente = false; // Antes de leer el instante: una señal nueva no se pierde
+        t_act = t->t_senal_us;
+    }
+    if (t->armada && (int32_t)(ahora - t->t_activacion_us) >= 0) {
+        if (!senal || (int32_t)(t->t_activacion_us - t_act) < 0) t_act = t->t_activacion_us;
+        if (t->periodo_us) {
+            uint32_t vencidas = (ahora - t->t_activacion_us) / t->periodo_us;
+            t->periodos_saltados += vencidas;
+            t->t_activacion_us += (vencidas + 1) * t->periodo_us;
+        } else {
+            t->armada = false;
+        }
+    }
+
+    uint32_t inicio = p->reloj();
+    t->fn(t->ctx);
+    uint32_t fin = p->reloj();
+
+    uint32_t exec = fin - inicio;
+    uint32_t retraso = inicio - t_act;
+    t->ejecuciones++;
+    t->exec_total_us += exec;
+    if (exec > t->exec_max_us) t->exec_max_us = exec;
+    if (retraso > t->retraso_max_us) t->retraso_max_us = retraso;
+    if ((int32_t)(fin - (t_act + t->plazo_us)) > 0) t->plazos_perdidos++;
+    return true;
+}
+
+/**
+ * @brief Tiempo hasta la próxima activación programada.
+ * @param p Planificador.
+ * @return µs hasta la próxima activación (0 si ya hay una lista), o PLANIFICADOR_SIN_PLAZO.
+ */
+uint32_t planificador_espera_us(const planificador_t *p) {
+    uint32_t ahora = p->reloj();
+    uint32_t espera = PLANIFICADOR_SIN_PLAZO;
+    for (uint32_t i = 0; i < p->num_tareas; i++) {
+        const tarea_t *t = &p->tareas[i];
+        if (t->pendiente) return 0;
+        if (!t->armada) continue;
+        int32_t falta = (int32_t)(t->t_activacion_us - ahora);
+        if (falta <= 0) return 0;
+        if ((uint32_t)falta < espera) espera = (uint32_t)falta;
+    }
+    return espera;
+}
+
+/**
+ * @brief Imprime las estadísticas de cada tarea y abre una ventana nueva.
+ * @param p Planificador.
+ */
+void planificador_imprimir(planificador_t *p) {
+    uint32_t ahora = p->reloj();
+    uint32_t ventana = ahora - p->t_ventana_us;
+    if (ventana == 0) ventana = 1;
+
+    for (uint32_t i = 0; i < p->num_tareas; i++) {
+        tarea_t *t = &p->tareas[i];
+        uint32_t media = t->ejecuciones ? (uint32_t)(t->exec_total_us / t->ejecuciones) : 0;
+        printf("[TAREA] %-10s prio=%u ejec=%lu cpu=%.2f%% exec_media=%luus exec_max=%luus "
+               "retraso_max=%luus plazos_perdidos=%lu saltados=%lu\n",
+               t->nombre, t->prioridad, (unsigned long)t->ejecuciones,
+               100.0f * (float)t->exec_total_us / (float)ventana, (unsigned long)media,
+               (unsigned long)t->exec_max_us, (unsigned long)t->retraso_max_us,
+               (unsigned long)t->plazos_perdidos, (unsigned long)t->periodos_saltados);
+
+        t->ejecuciones = 0;
+        t->plazos_perdidos = 0;
+        t->periodos_saltados = 0;
+        t->exec_max_us = 0;
+        t->exec_total_us = 0;
+        t->retraso_max_us = 0;
+    }
+    p->t_ventana_us = ahora;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file planificador.h
+ * @brief Planificador cooperativo por plazos (run-to-completion) compartido por guante y mano.
+ *
+ * Cada trabajo del bucle principal es una tarea periódica o por evento con una
+ * prioridad. planificador_ejecutar() corre hasta terminar la tarea lista de
+ * mayor prioridad y lleva, por tarea, tiempos de ejecución, retraso de inicio
+ * y plazos incumplidos.
+ *
+ * No depende del SDK: el reloj se inyecta en planificador_init(), así que el
+ * módulo compila y se puede probar en el host con un reloj simulado.
+ */
+
+#ifndef PLANIFICADOR_H
+#define PLANIFICADOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Máximo de tareas registradas. */
+#define PLANIFICADOR_MAX_TAREAS 8
+
+/** Espera devuelta por planificador_espera_us() cuando no hay activaciones programadas. */
+#define PLANIFICADOR_SIN_PLAZO  UINT32_MAX
+
+/** @brief Función de una tarea; debe terminar sin bloquear. */
+typedef void (*tarea_fn_t)(void *ctx);
+
+/** @brief Reloj en µs (con vuelta en 32 bits, p. ej. time_us_32). */
+typedef uint32_t (*planificador_reloj_t)(void);
+
+/**
+ * @brief Tarea registrada y sus estadísticas.
+ */
+typedef struct {
+    const char *nombre;          /**< Nombre para los logs. */
+    tarea_fn_t fn;               /**< Función de la tarea. */
+    void *ctx;                   /**< Contexto pasado a la función. */
+    uint8_t prioridad;           /**< 0 es la más alta. */
+    uint32_t periodo_us;         /**< Periodo (0 = tarea por evento). */
+    uint32_t plazo_us;           /**< Plazo relativo a la activación. */
+
+    bool armada;                 /**< Hay una activación programada en t_activacion_us. */
+    uint32_t t_activacion_us;    /**< Próxima activación programada. */
+    volatile bool pendiente;     /**< Señalada desde una IRQ o el main. */
+    volatile uint32_t t_senal_us;/**< Instante de la última señal. */
+
+    uint32_t ejecuciones;        /**< Ejecuciones en la ventana. */
+    uint32_t plazos_perdidos;    /**< Ejecuciones terminadas después de su plazo. */
+    uint32_t periodos_saltados;  /**< Activaciones periódicas perdidas por sobrecarga. */
+    uint32_t exec_max_us;        /**< Mayor tiempo de ejecución. */
+    uint64_t exec_total_us;      /**< Suma de tiempos de ejecución. */
+    uint32_t retraso_max_us;     /**< Mayor retraso entre activación e inicio. */
+} tarea_t;
+
+/**
+ * @brief Conjunto de tareas y reloj.
+ */
+typedef struct {
+    tarea_t tareas[PLANIFICADOR_MAX_TAREAS]; /**< Tareas registradas. */
+    uint32_t num_tareas;                     /**< Número de tareas registradas. */
+    planificador_reloj_t reloj;              /**< Reloj en µs. */
+    uint32_t t_ventana_us;                   /**< Inicio de la ventana de estadísticas. */
+} planificador_t;
+
+/**
+ * @brief Inicializa el planificador sin tareas.
+ * @param p     Planificador.
+ * @param reloj Reloj en µs.
+ */
+void planificador_init(planificador_t *p, planificador_reloj_t reloj);
+
+/**
+ * @brief Registra una tarea periódica; la primera activación es inmediata.
+ * @param p          Planificador.
+ * @param nombre     Nombre (literal).
+ * @param fn         Función de la tarea.
+ * @param ctx        Contexto de la función.
+ * @param prioridad  Prioridad (0 = más alta).
+ * @param periodo_us Periodo; también es su plazo.
+ * @return Identificador de la tarea, o -1 si no hay hueco.
+ */
+int planificador_periodica(planificador_t *p, const char *nombre, tarea_fn_t fn, void *ctx,
+                           uint8_t prioridad, uint32_t periodo_us);
+
+/**
+ * @brief Registra una tarea por evento (se activa con planificador_senalar o planificador_programar).
+ * @param p         Planificador.
+ * @param nombre    Nombre (literal).
+ * @param fn        Función de la tarea.
+ * @param ctx       Contexto de la función.
+ * @param prioridad Prioridad (0 = más alta).
+ * @param plazo_us  Plazo desde la señal o la activación programada.
+ * @return Identificador de la tarea, o -1 si no hay hueco.
+ */
+int planificador_evento(planificador_t *p, const char *nombre, tarea_fn_t fn, void *ctx,
+                        uint8_t prioridad, uint32_t plazo_us);
+
+/**
+ * @brief Señala una tarea para que se ejecute cuanto antes.
+ *
+ * Se puede llamar desde una IRQ. Quien la llame desde una IRQ debe despertar
+ * después al bucle principal (__sev()) si este duerme.
+ *
+ * @param p  Planificador.
+ * @param id Tarea.
+ */
+void planificador_senalar(planificador_t *p, int id);
+
+/**
+ * @brief Programa una activación de la tarea en un instante (solo desde el bucle principal).
+ * @param p    Planificador.
+ * @param id   Tarea.
+ * @param t_us Instante de activación.
+ */
+void planificador_programar(planificador_t *p, int id, uint32_t t_us);
+
+/**
+ * @brief Ejecuta hasta terminar la tarea lista de mayor prioridad.
+ * @param p Planificador.
+ * @return true si ejecutó una tarea (puede haber más listas), false si no había ninguna.
+ */
+bool planificador_ejecutar(planificador_t *p);
+
+/**
+ * @brief Tiempo hasta la próxima activación programada.
+ * @param p Planificador.
+ * @return µs hasta la próxima activación (0 si ya hay una lista), o PLANIFICADOR_SIN_PLAZO.
+ */
+uint32_t planificador_espera_us(const planificador_t *p);
+
+/**
+ * @brief Imprime las estadísticas de cada tarea y abre una ventana nueva.
+ * @param p Planificador.
+ */
+void planificador_imprimir(planificador_t *p);
+
+#endif /* PLANIFICADOR_H */
@@ -0,0 +1,71 @@
+/**
+ * @file reposo.c
+ * @brief Implementación de la espera de bajo consumo del bucle principal.
+ *
+ * Con pico_cyw43_arch_lwip_threadsafe_background la pila de red se atiende en
+ * IRQ, así que basta con dormir en WFE: cualquier interrupción despierta al
+ * núcleo. Con la variante poll se usa cyw43_arch_wait_for_work_until, que
+ * además atiende la pila al despertar.
+ */
+
+#include "reposo.h"
+
+#include <stdio.h>
+#include "pico/cyw43_arch.h"
+
+/**
+ * @brief Inicializa los contadores y abre la primera ventana.
+ * @param r Contadores a inicializar.
+ */
+void reposo_init(reposo_t *r) {
+    r->t_ventana_us = time_us_64();
+    r->reposo_us = 0;
+    r->esperas = 0;
+}
+
+/**
+ * @brief Duerme hasta `limite` (acotado a REPOSO_MAX_US) o hasta la próxima interrupción.
+ * @param r      Contadores de reposo.
+ * @param limite Próximo plazo conocido del bucle.
+ */
+void reposo_esperar(reposo_t *r, absolute_time_t limite) {
+    r->esperas++;
+#if REPOSO_HABILITADO
+    uint64_t inicio = time_us_64();
+    absolute_time_t tope = from_us_since_boot(inicio + REPOSO_MAX_US);
+    if (absolute_time_diff_us(tope, limite) > 0) limite = tope;
+    if (absolute_time_diff_us(get_absolute_time(), limite) <= 0) return;
+
+#if PICO_CYW43_ARCH_POLL
+    cyw43_arch_wait_for_work_until(limite);
+#else
+    best_effort_wfe_or_timeout(limite);
+#endif
+    r->reposo_us += time_us_64() - inicio;
+#else
+    (void)limite;
+#endif
+}
+
+/**
+ * @brief Fracción del tiempo en reposo en la ventana actual.
+ * @param r Contadores de reposo.
+ * @return Fracción en [0, 1].
+ */
+float reposo_fraccion(const reposo_t *r) {
+    uint64_t ventana = time_us_64() - r->t_ventana_us;
+    if (ventana == 0) return 0.0f;
+    return (float)r->reposo_us / (float)ventana;
+}
+
+/**
+ * @brief Imprime la fracción en reposo y de CPU ocupada, y abre una ventana nueva.
+ * @param r Contadores de reposo.
+ */
+void reposo_imprimir(reposo_t *r) {
+    float reposo = reposo_fraccion(r);
+    uint64_t ventana_ms = (time_us_64() - r->t_ventana_us) / 1000;
+    printf("[CPU] reposo=%.1f%% ocupada=%.1f%% esperas=%lu ventana=%lums\n",
+           100.0f * reposo, 100.0f * (1.0f - reposo), r->esperas, (uint32_t)ventana_ms);
+    reposo_init(r);
+}
@@ -0,0 +1,69 @@
+/**
+ * @file reposo.h
+ * @brief Espera de bajo consumo del bucle principal y medida de la fracción en reposo.
+ *
+ * Sustituye al busy-poll: el bucle duerme con WFE hasta su próximo plazo o
+ * hasta la próxima interrupción (timer, cyw43/lwIP, USB) y se contabiliza el
+ * tiempo dormido.
+ */
+
+#ifndef REPOSO_H
+#define REPOSO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+
+/**
+ * @brief 1 para dormir en las esperas; 0 reproduce el busy-poll (medida de referencia).
+ *
+ * Con 0 las esperas retornan en el acto y la fracción en reposo sale 0 %,
+ * lo que permite comparar consumo y latencia con el mismo binario.
+ */
+#ifndef REPOSO_HABILITADO
+#define REPOSO_HABILITADO 1
+#endif
+
+/** Espera máxima de una vuelta (µs), para revisar estados sin IRQ propia (enlace Wi-Fi). */
+#define REPOSO_MAX_US 20000
+
+/**
+ * @brief Contadores de la ventana de medida actual.
+ */
+typedef struct {
+    uint64_t t_ventana_us;  /**< Inicio de la ventana de medida. */
+    uint64_t reposo_us;     /**< Tiempo dormido en la ventana. */
+    uint32_t esperas;       /**< Esperas realizadas en la ventana. */
+} reposo_t;
+
+/**
+ * @brief Inicializa los contadores y abre la primera ventana.
+ * @param r Contadores a inicializar.
+ */
+void reposo_init(reposo_t *r);
+
+/**
+ * @brief Duerme hasta `limite` (acotado a REPOSO_MAX_US) o hasta la próxima interrupción.
+ *
+ * Las IRQ que levantan banderas para el bucle deben llamar a __sev() para no
+ * perder el despertar si la bandera se levanta justo antes de dormir.
+ *
+ * @param r      Contadores de reposo.
+ * @param limite Próximo plazo conocido del bucle.
+ */
+void reposo_esperar(reposo_t *r, absolute_time_t limite);
+
+/**
+ * @brief Fracción del tiempo en reposo en la ventana actual.
+ * @param r Contadores de reposo.
+ * @return Fracción en [0, 1].
+ */
+float reposo_fraccion(const reposo_t *r);
+
+/**
+ * @brief Imprime la fracción en reposo y de CPU ocupada, y abre una ventana nueva.
+ * @param r Contadores de reposo.
+ */
+void reposo_imprimir(reposo_t *r);
+
+#endif /* REPOSO_H */
@@ -0,0 +1,495 @@
+/**
+ * @file reproductor.c
+ * @brief Reproduce en el PC una sesión de tramas a través de la recepción y el predictor de la mano.
+ *
+ * Pasa cada trama por Pico_Server/lib/recepcion y Pico_Server/lib/prediccion
+ * igual que lo hace el firmware (callback UDP + tarea de reproducción), con
+ * los instantes del fichero en lugar de time_us_32(). Como conoce la verdad
+ * del guante, mide la pérdida efectiva, la latencia extremo a extremo y el
+ * error de seguimiento con y sin predicción.
+ *
+ * Entrada, una trama por línea:
+ * - `E <t_us> <trama>`: la trama entra en la red cuando el guante toma su
+ *   última muestra; `R <t_us> <trama>`: la trama llega a la mano. Es lo que
+ *   escribe `tools/emulador_red.py --volcar`.
+ * - `TX[n]: S,...`: log de consola del guante (LOG_TRAMAS); cada trama llega
+ *   a la mano --retardo-ms después de su marca de tiempo, sin pérdidas.
+ *
+ * Uso:
+ *   reproductor [--alpha A] [--beta B] [--servo-ms MS] [--retardo-ms MS] [--barrido] <fichero>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "lib/recepcion/recepcion.h"
+#include "lib/prediccion/prediccion.h"
+
+/** @brief Longitud máxima de una línea del fichero de entrada. */
+#define LINEA_MAX           1024
+
+/**
+ * @brief Trama del fichero con su instante de llegada a la mano.
+ */
+typedef struct {
+    uint64_t t_us;      /**< Instante de llegada (reloj del fichero). */
+    uint32_t orden;     /**< Posición en el fichero, para ordenar de forma estable. */
+    char    *texto;     /**< Trama tal como viaja por UDP. */
+} llegada_t;
+
+/**
+ * @brief Estado real del guante para una secuencia.
+ */
+typedef struct {
+    bool     valido;                    /**< Ya se vio la muestra en alguna trama `E`. */
+    uint64_t t_us;                      /**< Instante en que se tomó (reloj del fichero). */
+    uint8_t  valores[RECEPCION_DEDOS];  /**< Valores de los dedos. */
+} verdad_t;
+
+/**
+ * @brief Sesión cargada: tramas que llegan a la mano y verdad del guante.
+ */
+typedef struct {
+    llegada_t *llegadas;    /**< Tramas entregadas, ordenadas por llegada. */
+    uint32_t   num_llegadas;
+    uint32_t   cap_llegadas;
+    verdad_t  *verdad;      /**< Verdad indexada por seq - seq_base. */
+    uint32_t   num_verdad;
+    uint32_t   seq_base;    /**< Secuencia de verdad[0]. */
+    uint32_t   enviadas;    /**< Tramas que entraron en la red. */
+} sesion_t;
+
+/**
+ * @brief Parámetros de una reproducción.
+ */
+typedef struct {
+    float    alpha;         /**< Ganancia de posición del predictor. */
+    float    beta;          /**< Ganancia de velocidad del predictor. */
+    bool     prediccion;    /**< Proyectar o entregar la última medida. */
+    uint32_t servo_us;      /**< Retraso de los servos: la salida se compara con la verdad de este tiempo después. */
+} parametros_t;
+
+/**
+ * @brief Resultado de una reproducción.
+ */
+typedef struct {
+    recepcion_t rx;         /**< Receptor al terminar (estadísticas y playout). */
+    uint32_t    salidas;    /**< Actualizaciones de los servos. */
+    float      *latencias;  /**< Latencia extremo a extremo de cada salida (ms). */
+    uint32_t    num_latencias;
+    float      *errores;    /**< Error medio por dedo de cada salida (unidades 0-9). */
+    uint32_t    num_errores;
+    float       error_predictor; /**< prediccion_error_medio() al terminar. */
+} resultado_t;
+
+/**
+ * @brief realloc que aborta si no hay memoria.
+ * @param p     Bloque actual (o NULL).
+ * @param bytes Tamaño nuevo.
+ * @return Bloque redimensionado.
+ */
+static void *redimensionar(void *p, size_t bytes) {
+    p = realloc(p, bytes);
+    if (!p) {
+        fprintf(stderr, "reproductor: sin memoria\n");
+        exit(1);
+    }
+    return p;
+}
+
+/**
+ * @brief Añade una trama entregada a la mano.
+ * @param s     Sesión.
+ * @param t_us  Instante de llegada.
+ * @param texto Trama (se copia).
+ */
+static void agregar_llegada(sesion_t *s, uint64_t t_us, const char *texto) {
+    if (s->num_llegadas == s->cap_llegadas) {
+        s->cap_llegadas = s->cap_llegadas ? 2 * s->cap_llegadas : 1024;
+        s->llegadas = redimensionar(s->llegadas, s->cap_llegadas * sizeof(llegada_t));
+    }
+    llegada_t *l = &s->llegadas[s->num_llegadas];
+    l->t_us = t_us;
+    l->orden = s->num_llegadas++;
+    l->texto = strdup(texto);
+}
+
+/**
+ * @brief Guarda como verdad los estados de una trama que entra en la red.
+ * @param s    Sesión.
+ * @param t_us Instante de la última muestra de la trama.
+ * @param t    Trama decodificada.
+ */
+static void agregar_verdad(sesion_t *s, uint64_t t_us, const trama_t *t) {
+    if (!t->secuenciada) return;
+    if (s->num_verdad == 0) s->seq_base = t->seq - (t->n - 1);
+    for (uint32_t k = 0; k < t->n; k++) {
+        uint32_t atras = (t->n - 1) - k;
+        uint32_t i = t->seq - atras - s->seq_base;
+        if ((int32_t)i < 0) continue; // Anterior a la primera trama
+        if (i >= s->num_verdad) {
+            s->verdad = redimensionar(s->verdad, (i + 1) * sizeof(verdad_t));
+            memset(&s->verdad[s->num_verdad], 0, (i + 1 - s->num_verdad) * sizeof(verdad_t));
+            s->num_verdad = i + 1;
+        }
+        verdad_t *v = &s->verdad[i];
+        if (v->valido) continue;
+        v->valido = true;
+        v->t_us = t_us - (uint64_t)atras * t->periodo_us;
+        memcpy(v->valores, t->estados[k], RECEPCION_DEDOS);
+    }
+}
+
+/**
+ * @brief Ordena las llegadas por instante y, a igual instante, por posición en el fichero.
+ * @param a Primera llegada.
+ * @param b Segunda llegada.
+ * @return Negativo, cero o positivo como strcmp.
+ */
+static int comparar_llegadas(const void *a, const void *b) {
+    const llegada_t *x = a, *y = b;
+    if (x->t_us != y->t_us) return x->t_us < y->t_us ? -1 : 1;
+    return x->orden < y->orden ? -1 : (x->orden > y->orden);
+}
+
+/**
+ * @brief Carga un volcado del emulador o un log de consola del guante.
+ * @param ruta       Fichero de entrada.
+ * @param retardo_us Retardo de red fijo para los logs `TX[n]:`.
+ * @param s          Sesión a rellenar.
+ * @return true si se leyó al menos una trama.
+ */
+static bool cargar_sesion(const char *ruta, uint32_t retardo_us, sesion_t *s) {
+    FILE *f = fopen(ruta, "r");
+    if (!f) {
+        perror(ruta);
+        return false;
+    }
+    memset(s, 0, sizeof(*s));
+
+    static char linea[LINEA_MAX];
+    static trama_t trama;
+    while (fgets(linea, sizeof(linea), f)) {
+        linea[strcspn(linea, "\r\n")] = '\0';
+
+        char tipo = linea[0];
+        unsigned long long t;
+        int usados = 0;
+        if ((tipo == 'E' || tipo == 'R') && sscanf(linea + 1, " %llu %n", &t, &usados) == 1 && usados > 0) {
+            const char *texto = linea + 1 + usados;
+            if (tipo == 'R') {
+                agregar_llegada(s, t, texto);
+            } else if (recepcion_parsear(texto, &trama)) {
+                agregar_verdad(s, t, &trama);
+                s->enviadas++;
+            }
+            continue;
+        }
+
+        // Log del guante: la marca de tiempo de la trama es la de su última muestra
+        const char *texto = strstr(linea, "TX[");
+        if (texto) texto = strstr(texto, ": S,");
+        if (!texto || !recepcion_parsear(texto + 2, &trama)) continue;
+        agregar_verdad(s, trama.t_us, &trama);
+        agregar_llegada(s, (uint64_t)trama.t_us + retardo_us, texto + 2);
+        s->enviadas++;
+    }
+    fclose(f);
+
+    qsort(s->llegadas, s->num_llegadas, sizeof(llegada_t), comparar_llegadas);
+    return s->num_llegadas > 0 && s->num_verdad > 0;
+}
+
+/**
+ * @brief Verdad del guante en un instante: la última muestra tomada hasta entonces.
+ * @param s    Sesión.
+ * @param t_us Instante (reloj del fichero).
+ * @return Muestra, o NULL si el instante queda fuera de la sesión.
+ */
+static const verdad_t *verdad_en(const sesion_t *s, uint64_t t_us) {
+    // Búsqueda binaria: las muestras están en orden de secuencia y de tiempo
+    uint32_t lo = 0, hi = s->num_verdad;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (s->verdad[mid].valido && s->verdad[mid].t_us > t_us) hi = mid;
+        else lo = mid + 1;
+    }
+    if (lo == 0 || lo == s->num_verdad) return NULL; // Antes de la primera o después de la última
+    const verdad_t *v = &s->verdad[lo - 1];
+    return v->valido ? v : NULL;
+}
+
+/**
+ * @brief Añade un valor a un vector dinámico de floats.
+ * @param v   Vector.
+ * @param n   Elementos usados.
+ * @param x   Valor a añadir.
+ */
+static void agregar_float(float **v, uint32_t *n, float x) {
+    if ((*n & (*n - 1)) == 0) *v = redimensionar(*v, (*n ? 2 * *n : 1) * sizeof(float));
+    (*v)[(*n)++] = x;
+}
+
+/**
+ * @brief Tarea de reproducción sobre el reloj del fichero.
+ *
+ * Da el mismo paso que tarea_playout_fn (recepcion_reproducir()) y compara la
+ * salida con la verdad del guante.
+ *
+ * @param rx        Receptor.
+ * @param pred      Predictor.
+ * @param s         Sesión (verdad).
+ * @param par       Parámetros.
+ * @param ahora     Instante actual.
+ * @param res       Resultado a acumular.
+ * @param[out] t_proxima Próxima activación programada.
+ * @return true si quedó una activación programada.
+ */
+static bool tarea_playout(recepcion_t *rx, prediccion_t *pred, const sesion_t *s, const parametros_t *par,
+                          uint64_t ahora, resultado_t *res, uint32_t *t_proxima) {
+    reproduccion_t rep;
+    bool aplicar = recepcion_reproducir(rx, pred, (uint32_t)ahora, &rep);
+    *t_proxima = rep.t_proxima;
+    if (!aplicar) return rep.programada;
+    res->salidas++;
+
+    // Latencia real: desde que el guante tomó la muestra hasta que llega a los servos
+    uint32_t i = rep.seq - s->seq_base;
+    if (i < s->num_verdad && s->verdad[i].valido) {
+        agregar_float(&res->latencias, &res->num_latencias, (float)(ahora - s->verdad[i].t_us) / 1000.0f);
+    }
+
+    // Error: lo que marca la mano frente a la mano real cuando los servos llegan
+    const verdad_t *v = verdad_en(s, ahora + par->servo_us);
+    if (v) {
+        float error = 0.0f;
+        for (int d = 0; d < RECEPCION_DEDOS; d++) error += fabsf(rep.valores[d] - (float)v->valores[d]);
+        agregar_float(&res->errores, &res->num_errores, error / RECEPCION_DEDOS);
+    }
+    return rep.programada;
+}
+
+/**
+ * @brief Reproduce la sesión: cada llegada pasa por el receptor y despierta la tarea de reproducción.
+ * @param s   Sesión.
+ * @param par Parámetros.
+ * @param res Resultado (se inicializa).
+ */
+static void reproducir(const sesion_t *s, const parametros_t *par, resultado_t *res) {
+    static trama_t trama;
+    static prediccion_t pred;
+    memset(res, 0, sizeof(*res));
+    recepcion_init(&res->rx);
+    prediccion_init(&pred, RECEPCION_DEDOS, par->alpha, par->beta, (float)RECEPCION_VMAX);
+    prediccion_habilitar(&pred, par->prediccion);
+
+    // Reloj de 64 bits para la verdad; la mano ve sus 32 bits bajos, como time_us_32()
+    uint32_t i = 0;
+    bool programada = false;
+    uint32_t t_prog = 0;
+    uint64_t ahora = 0;
+    while (i < s->num_llegadas || programada) {
+        const llegada_t *l = (i < s->num_llegadas) ? &s->llegadas[i] : NULL;
+        if (programada && (!l || (int32_t)(t_prog - (uint32_t)l->t_us) < 0)) {
+            ahora += (uint32_t)(t_prog - (uint32_t)ahora);
+            programada = false;
+        } else {
+            ahora = l->t_us;
+            i++;
+            if (recepcion_parsear(l->texto, &trama)) {
+                res->rx.stats.tramas++;
+                res->rx.stats.bytes += (uint32_t)strlen(l->texto);
+                recepcion_procesar(&res->rx, &trama, (uint32_t)ahora);
+            } else {
+                res->rx.stats.invalidas++;
+            }
+        }
+        programada = tarea_playout(&res->rx, &pred, s, par, ahora, res, &t_prog);
+    }
+    res->error_predictor = prediccion_error_medio(&pred);
+}
+
+/**
+ * @brief Ordena floats de menor a mayor.
+ * @param a Primer valor.
+ * @param b Segundo valor.
+ * @return Negativo, cero o positivo como strcmp.
+ */
+static int comparar_float(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Percentil p (0-100) por el método del rango más cercano; ordena el vector.
+ * @param v Valores.
+ * @param n Número de valores.
+ * @param p Percentil.
+ * @return Valor del percentil (NAN si no hay datos).
+ */
+static float percentil(float *v, uint32_t n, float p) {
+    if (n == 0) return NAN;
+    qsort(v, n, sizeof(float), comparar_float);
+    uint32_t k = (uint32_t)ceilf(p / 100.0f * (float)n);
+    return v[k > 0 ? k - 1 : 0];
+}
+
+/**
+ * @brief Error medio de un resultado.
+ * @param res Resultado.
+ * @return Media de los errores por salida (NAN si no hay).
+ */
+static float error_medio(const resultado_t *res) {
+    double suma = 0.0;
+    for (uint32_t i = 0; i < res->num_errores; i++) suma += res->errores[i];
+    return res->num_errores ? (float)(suma / res->num_errores) : NAN;
+}
+
+/**
+ * @brief Libera los vectores de un resultado.
+ * @param res Resultado.
+ */
+static void liberar(resultado_t *res) {
+    free(res->latencias);
+    free(res->errores);
+}
+
+/**
+ * @brief Imprime la línea de error de seguimiento de una reproducción.
+ * @param nombre Etiqueta de la reproducción.
+ * @param res    Resultado.
+ */
+static void imprimir_error(const char *nombre, resultado_t *res) {
+    float medio = error_medio(res);
+    double cuad = 0.0;
+    for (uint32_t i = 0; i < res->num_errores; i++) cuad += (double)res->errores[i] * res->errores[i];
+    float rms = res->num_errores ? (float)sqrt(cuad / res->num_errores) : NAN;
+    printf("[%s] salidas=%u error (0-9) medio=%.3f rms=%.3f p95=%.3f max=%.3f predictor=%.3f\n",
+           nombre, res->salidas, medio, rms, percentil(res->errores, res->num_errores, 95.0f),
+           percentil(res->errores, res->num_errores, 100.0f), res->error_predictor);
+}
+
+/**
+ * @brief Imprime las estadísticas de recepción, playout y latencia.
+ * @param s   Sesión.
+ * @param res Resultado.
+ */
+static void imprimir_recepcion(const sesion_t *s, resultado_t *res) {
+    const rx_stats_t *st = &res->rx.stats;
+    const playout_t *pl = &res->rx.playout;
+    uint32_t estados = st->estados ? st->estados : 1;
+    printf("[RED] enviadas=%u entregadas=%u\n", s->enviadas, s->num_llegadas);
+    printf("[RX] tramas=%u bytes=%u invalidas=%u estados=%u recuperados=%u "
+           "perdidos=%u (%.2f%%) desbordes=%u saltados=%u reinicios=%u\n",
+           st->tramas, st->bytes, st->invalidas, st->estados, st->recuperados, st->perdidos,
+           100.0f * (float)st->perdidos / (float)estados, st->desbordes, st->saltados, st->reinicios);
+    printf("[PLAYOUT] retardo=%dus objetivo=%dus jitter=%d/%dus descartes_tardios=%u\n",
+           pl->retardo_us, pl->objetivo_us, pl->espera_media_us, pl->espera_desv_us,
+           pl->descartes_tardios);
+    printf("[LATENCIA] p50=%.1fms p95=%.1fms p99=%.1fms max=%.1fms\n",
+           percentil(res->latencias, res->num_latencias, 50.0f),
+           percentil(res->latencias, res->num_latencias, 95.0f),
+           percentil(res->latencias, res->num_latencias, 99.0f),
+           percentil(res->latencias, res->num_latencias, 100.0f));
+}
+
+/**
+ * @brief Barrido de alpha y beta: error medio de seguimiento de cada combinación.
+ * @param s   Sesión.
+ * @param par Parámetros base (servo_us).
+ */
+static void barrido(const sesion_t *s, parametros_t par) {
+    static const float alphas[] = { 0.02f, 0.05f, 0.1f, 0.2f, 0.3f, 0.5f };
+    static const float betas[] = { 0.001f, 0.003f, 0.01f, 0.03f };
+    static resultado_t res;
+
+    par.prediccion = false;
+    reproducir(s, &par, &res);
+    printf("[BARRIDO] sin prediccion: %.3f\n", error_medio(&res));
+    liberar(&res);
+
+    printf("[BARRIDO] alpha \\ beta");
+    for (size_t j = 0; j < sizeof(betas) / sizeof(betas[0]); j++) printf(" %7.3f", betas[j]);
+    printf("\n");
+    par.prediccion = true;
+    for (size_t i = 0; i < sizeof(alphas) / sizeof(alphas[0]); i++) {
+        printf("[BARRIDO] %5.2f       ", alphas[i]);
+        for (size_t j = 0; j < sizeof(betas) / sizeof(betas[0]); j++) {
+            par.alpha = alphas[i];
+            par.beta = betas[j];
+            reproducir(s, &par, &res);
+            printf(" %7.3f", error_medio(&res));
+            liberar(&res);
+        }
+        printf("\n");
+    }
+}
+
+/**
+ * @brief Muestra el uso.
+ */
+static void uso(void) {
+    fprintf(stderr, "uso: reproductor [--alpha A] [--beta B] [--servo-ms MS] [--retardo-ms MS] "
+                    "[--barrido] <fichero>\n");
+}
+
+/**
+ * @brief Punto de entrada.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos.
+ * @return 0 si se reprodujo la sesión, 1 si hubo un error.
+ */
+int main(int argc, char **argv) {
+    parametros_t par = {
+        .alpha = PREDICCION_ALPHA,
+        .beta = PREDICCION_BETA,
+        .servo_us = 20000,
+    };
+    uint32_t retardo_us = 20000;
+    bool hacer_barrido = false;
+    const char *ruta = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--alpha") == 0 && valor) par.alpha = strtof(argv[++i], NULL);
+        else if (strcmp(argv[i], "--beta") == 0 && valor) par.beta = strtof(argv[++i], NULL);
+        else if (strcmp(argv[i], "--servo-ms") == 0 && valor) par.servo_us = (uint32_t)(1000.0 * atof(argv[++i]));
+        else if (strcmp(argv[i], "--retardo-ms") == 0 && valor) retardo_us = (uint32_t)(1000.0 * atof(argv[++i]));
+        else if (strcmp(argv[i], "--barrido") == 0) hacer_barrido = true;
+        else if (argv[i][0] != '-' && !ruta) ruta = argv[i];
+        else {
+            uso();
+            return 1;
+        }
+    }
+    if (!ruta) {
+        uso();
+        return 1;
+    }
+
+    static sesion_t sesion;
+    if (!cargar_sesion(ruta, retardo_us, &sesion)) {
+        fprintf(stderr, "reproductor: sin tramas en %s\n", ruta);
+        return 1;
+    }
+
+    static resultado_t con, sin;
+    par.prediccion = true;
+    reproducir(&sesion, &par, &con);
+    par.prediccion = false;
+    reproducir(&sesion, &par, &sin);
+
+    imprimir_recepcion(&sesion, &con);
+    printf("[PRED] alpha=%.3f beta=%.4f servo=%.1fms\n", par.alpha, par.beta, par.servo_us / 1000.0f);
+    imprimir_error("CON PREDICCION", &con);
+    imprimir_error("SIN PREDICCION", &sin);
+    liberar(&con);
+    liberar(&sin);
+
+    if (hacer_barrido) barrido(&sesion, par);
+    return 0;
+}
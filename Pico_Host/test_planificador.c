@@ -0,0 +1,248 @@
+/**
+ * @file test_planificador.c
+ * @brief Prueba en el host de Pico_Common/lib/planificador con un reloj simulado.
+ *
+ * Cubre el orden por prioridad, las activaciones periódicas saltadas, la
+ * cuenta de plazos incumplidos y planificador_espera_us(), incluida la vuelta
+ * del contador de 32 bits.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lib/planificador/planificador.h"
+
+/** @brief Comprueba una condición y cuenta el fallo sin abortar la prueba. */
+#define COMPROBAR(cond) comprobar((cond), #cond, __FILE__, __LINE__)
+
+/** @brief Instante actual del reloj simulado (µs). */
+static uint32_t reloj_us = 0;
+/** @brief Comprobaciones fallidas. */
+static int fallos = 0;
+
+/** @brief Orden en que se ejecutaron las tareas (su contexto). */
+static int orden[16];
+/** @brief Ejecuciones registradas en orden[]. */
+static int num_orden = 0;
+/** @brief Tiempo que consume cada ejecución de tarea_fn (µs). */
+static uint32_t exec_us = 0;
+
+/**
+ * @brief Reloj simulado que se inyecta en el planificador.
+ * @return Instante actual (µs).
+ */
+static uint32_t reloj(void) {
+    return reloj_us;
+}
+
+/**
+ * @brief Registra un fallo si la condición es falsa.
+ * @param ok     Resultado de la condición.
+ * @param texto  Condición como texto.
+ * @param fichero Fichero de la comprobación.
+ * @param linea  Línea de la comprobación.
+ */
+static void comprobar(bool ok, const char *texto, const char *fichero, int linea) {
+    if (ok) return;
+    fallos++;
+    printf("%s:%d: falla %s\n", fichero, linea, texto);
+}
+
+/**
+ * @brief Tarea de prueba: anota su identificador y avanza el reloj exec_us.
+ * @param ctx Identificador (int codificado en el puntero).
+ */
+static void tarea_fn(void *ctx) {
+    if (num_orden < (int)(sizeof(orden) / sizeof(orden[0]))) orden[num_orden++] = (int)(intptr_t)ctx;
+    reloj_us += exec_us;
+}
+
+/**
+ * @brief Reinicia el reloj y el registro de ejecuciones.
+ * @param p     Planificador a inicializar.
+ * @param t0_us Instante inicial del reloj.
+ */
+static void preparar(planificador_t *p, uint32_t t0_us) {
+    reloj_us = t0_us;
+    num_orden = 0;
+    exec_us = 0;
+    planificador_init(p, reloj);
+}
+
+/**
+ * @brief Gana la menor prioridad y, a igual prioridad, la registrada antes.
+ */
+static void prueba_prioridad(void) {
+    planificador_t p;
+    preparar(&p, 1000);
+    int a = planificador_evento(&p, "a", tarea_fn, (void *)1, 2, 1000);
+    int b = planificador_evento(&p, "b", tarea_fn, (void *)2, 0, 1000);
+    int c = planificador_evento(&p, "c", tarea_fn, (void *)3, 1, 1000);
+    int d = planificador_evento(&p, "d", tarea_fn, (void *)4, 0, 1000);
+
+    COMPROBAR(!planificador_ejecutar(&p));
+    planificador_senalar(&p, a);
+    planificador_senalar(&p, b);
+    planificador_senalar(&p, c);
+    planificador_senalar(&p, d);
+    while (planificador_ejecutar(&p)) {}
+
+    COMPROBAR(num_orden == 4);
+    COMPROBAR(orden[0] == 2 && orden[1] == 4 && orden[2] == 3 && orden[3] == 1);
+
+    // Una señal nueva de mayor prioridad adelanta a una que ya esperaba
+    num_orden = 0;
+    planificador_senalar(&p, a);
+    planificador_senalar(&p, c);
+    COMPROBAR(planificador_ejecutar(&p));
+    planificador_senalar(&p, b);
+    while (planificador_ejecutar(&p)) {}
+    COMPROBAR(num_orden == 3 && orden[0] == 3 && orden[1] == 2 && orden[2] == 1);
+
+    // Sin hueco para más tareas
+    for (int i = 4; i < PLANIFICADOR_MAX_TAREAS; i++) {
+        COMPROBAR(planificador_evento(&p, "x", tarea_fn, NULL, 3, 1000) == i);
+    }
+    COMPROBAR(planificador_evento(&p, "x", tarea_fn, NULL, 3, 1000) == -1);
+    COMPROBAR(planificador_periodica(&p, "y", tarea_fn, NULL, 3, 0) == -1);
+}
+
+/**
+ * @brief Una periódica retrasada no acumula ejecuciones: salta las vencidas.
+ */
+static void prueba_periodos_saltados(void) {
+    planificador_t p;
+    preparar(&p, 0);
+    int t = planificador_periodica(&p, "per", tarea_fn, NULL, 0, 1000);
+
+    // Primera activación inmediata
+    COMPROBAR(planificador_ejecutar(&p));
+    COMPROBAR(!planificador_ejecutar(&p));
+    COMPROBAR(p.tareas[t].t_activacion_us == 1000);
+
+    // Llega 2,5 periodos tarde: una ejecución, dos activaciones saltadas
+    reloj_us = 3500;
+    COMPROBAR(planificador_ejecutar(&p));
+    COMPROBAR(!planificador_ejecutar(&p));
+    COMPROBAR(p.tareas[t].ejecuciones == 2);
+    COMPROBAR(p.tareas[t].periodos_saltados == 2);
+    COMPROBAR(p.tareas[t].t_activacion_us == 4000);
+    COMPROBAR(p.tareas[t].retraso_max_us == 2500); // Desde la primera activación vencida
+
+    // A tiempo: sin saltos nuevos y la fase se mantiene
+    reloj_us = 4000;
+    COMPROBAR(planificador_ejecutar(&p));
+    COMPROBAR(p.tareas[t].periodos_saltados == 2);
+    COMPROBAR(p.tareas[t].t_activacion_us == 5000);
+}
+
+/**
+ * @brief Plazo medido desde la activación: cuenta el retraso de inicio más la ejecución.
+ */
+static void prueba_plazos(void) {
+    planificador_t p;
+    preparar(&p, 0);
+    int t = planificador_evento(&p, "ev", tarea_fn, NULL, 0, 100);
+
+    // Empieza 50 µs tarde y tarda 40: termina en 90, dentro del plazo
+    planificador_senalar(&p, t);
+    reloj_us = 50;
+    exec_us = 40;
+    COMPROBAR(planificador_ejecutar(&p));
+    COMPROBAR(p.tareas[t].plazos_perdidos == 0);
+    COMPROBAR(p.tareas[t].retraso_max_us == 50);
+    COMPROBAR(p.tareas[t].exec_max_us == 40);
+
+    // Tarda 150: termina después del plazo
+    planificador_senalar(&p, t);
+    exec_us = 150;
+    COMPROBAR(planificador_ejecutar(&p));
+    COMPROBAR(p.tareas[t].plazos_perdidos == 1);
+    COMPROBAR(p.tareas[t].exec_max_us == 150);
+    COMPROBAR(p.tareas[t].exec_total_us == 190);
+
+    // Activación programada y señal a la vez: el plazo cuenta desde la más antigua
+    exec_us = 0;
+    planificador_programar(&p, t, reloj_us + 10);
+    reloj_us += 20;
+    planificador_senalar(&p, t);
+    reloj_us += 95;
+    COMPROBAR(planificador_ejecutar(&p));
+    COMPROBAR(p.tareas[t].plazos_perdidos == 2);
+    COMPROBAR(p.tareas[t].retraso_max_us == 105);
+    COMPROBAR(!p.tareas[t].armada);
+
+    // La ventana de estadísticas se reinicia al imprimir
+    planificador_imprimir(&p);
+    COMPROBAR(p.tareas[t].plazos_perdidos == 0 && p.tareas[t].ejecuciones == 0);
+}
+
+/**
+ * @brief Espera hasta la próxima activación, también con la vuelta del reloj.
+ */
+static void prueba_espera(void) {
+    planificador_t p;
+    preparar(&p, 0);
+    int ev = planificador_evento(&p, "ev", tarea_fn, NULL, 0, 1000);
+    COMPROBAR(planificador_espera_us(&p) == PLANIFICADOR_SIN_PLAZO);
+
+    planificador_programar(&p, ev, 300);
+    COMPROBAR(planificador_espera_us(&p) == 300);
+    reloj_us = 300;
+    COMPROBAR(planificador_espera_us(&p) == 0);
+    COMPROBAR(planificador_ejecutar(&p));
+    COMPROBAR(planificador_espera_us(&p) == PLANIFICADOR_SIN_PLAZO);
+
+    // Una señal pendiente no espera
+    planificador_senalar(&p, ev);
+    COMPROBAR(planificador_espera_us(&p) == 0);
+    COMPROBAR(planificador_ejecutar(&p));
+
+    // Gana la activación más cercana entre varias tareas
+    int per = planificador_periodica(&p, "per", tarea_fn, NULL, 1, 5000);
+    COMPROBAR(planificador_espera_us(&p) == 0); // Periódica recién registrada
+    COMPROBAR(planificador_ejecutar(&p));
+    COMPROBAR(planificador_espera_us(&p) == 5000);
+    planificador_programar(&p, ev, reloj_us + 700);
+    COMPROBAR(planificador_espera_us(&p) == 700);
+
+    // Vuelta del contador: activación "después" de 0xFFFFFFFF
+    preparar(&p, UINT32_MAX - 100);
+    ev = planificador_evento(&p, "ev", tarea_fn, NULL, 0, 1000);
+    planificador_programar(&p, ev, 200);
+    COMPROBAR(planificador_espera_us(&p) == 301);
+    COMPROBAR(!planificador_ejecutar(&p));
+    reloj_us = 200;
+    COMPROBAR(planificador_espera_us(&p) == 0);
+    COMPROBAR(planificador_ejecutar(&p));
+
+    // Periódica que cruza la vuelta sin saltar activaciones
+    preparar(&p, UINT32_MAX - 1500);
+    per = planificador_periodica(&p, "per", tarea_fn, NULL, 0, 1000);
+    COMPROBAR(planificador_ejecutar(&p));
+    reloj_us += 1000;
+    COMPROBAR(planificador_ejecutar(&p));
+    reloj_us += 1000;
+    COMPROBAR(planificador_ejecutar(&p));
+    COMPROBAR(p.tareas[per].periodos_saltados == 0);
+    COMPROBAR(planificador_espera_us(&p) == 1000);
+}
+
+/**
+ * @brief Ejecuta todas las pruebas.
+ * @return 0 si todas pasan, 1 si alguna falla.
+ */
+int main(void) {
+    prueba_prioridad();
+    prueba_periodos_saltados();
+    prueba_plazos();
+    prueba_espera();
+
+    if (fallos) {
+        printf("test_planificador: %d comprobaciones fallidas\n", fallos);
+        return 1;
+    }
+    printf("test_planificador: ok\n");
+    return 0;
+}
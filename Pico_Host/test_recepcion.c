@@ -0,0 +1,118 @@
+/**
+ * @file test_recepcion.c
+ * @brief Prueba en el host de Pico_Server/lib/recepcion con instantes simulados.
+ *
+ * Cubre el orden de la cola cuando el retardo total (offset + playout) baja
+ * entre dos tramas y la cuenta como perdidos de los estados que llegan tarde.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lib/recepcion/recepcion.h"
+
+/** @brief Comprueba una condición y cuenta el fallo sin abortar la prueba. */
+#define COMPROBAR(cond) comprobar((cond), #cond, __FILE__, __LINE__)
+
+/** @brief Periodo de muestreo de las tramas de prueba (µs). */
+#define PERIODO_US  2000
+/** @brief Muestras por lote de las tramas de prueba. */
+#define LOTE        10
+
+/** @brief Comprobaciones fallidas. */
+static int fallos = 0;
+
+/**
+ * @brief Registra un fallo si la condición es falsa.
+ * @param ok     Resultado de la condición.
+ * @param texto  Condición como texto.
+ * @param fichero Fichero de la comprobación.
+ * @param linea  Línea de la comprobación.
+ */
+static void comprobar(bool ok, const char *texto, const char *fichero, int linea) {
+    if (ok) return;
+    fallos++;
+    printf("%s:%d: falla %s\n", fichero, linea, texto);
+}
+
+/**
+ * @brief Arma una trama secuenciada de un lote sin redundancia.
+ * @param t    Trama a rellenar.
+ * @param seq  Secuencia del estado más reciente.
+ * @param t_us Marca de tiempo del emisor del estado más reciente.
+ */
+static void armar_trama(trama_t *t, uint32_t seq, uint32_t t_us) {
+    t->secuenciada = true;
+    t->seq = seq;
+    t->t_us = t_us;
+    t->periodo_us = PERIODO_US;
+    t->n = LOTE;
+    for (int k = 0; k < LOTE; k++) {
+        for (int i = 0; i < RECEPCION_DEDOS; i++) t->estados[k][i] = (uint8_t)((seq + k) % 10);
+    }
+}
+
+/**
+ * @brief Un tránsito más corto acorta el retardo total: la cola no se desordena.
+ *
+ * La primera trama llega con 50 ms de tránsito y la segunda con 31 ms. El
+ * offset de reloj baja 19 ms y el retardo de reproducción sube menos, así que
+ * algunos estados nuevos caen antes que el último encolado. Sin la cola monótona
+ * quedarían detrás de él y recepcion_extraer() no los vería vencer.
+ */
+static void prueba_retardo_baja(void) {
+    static recepcion_t r;
+    static trama_t t;
+    recepcion_init(&r);
+
+    armar_trama(&t, 10, 20000);
+    recepcion_procesar(&r, &t, 70000);
+    COMPROBAR(recepcion_profundidad(&r) == 1);
+    uint32_t t_primera;
+    COMPROBAR(recepcion_proxima(&r, &t_primera));
+
+    armar_trama(&t, 20, 40000);
+    recepcion_procesar(&r, &t, 71000);
+    COMPROBAR(r.playout.offset_reloj == 31000);
+    // El estado nuevo más antiguo que no vence al llegar cae antes que la muestra ya encolada
+    uint32_t t_play_ultimo = t.t_us + r.playout.offset_reloj + (uint32_t)r.playout.retardo_us;
+    uint32_t t_play_viejo = t_play_ultimo - (t_play_ultimo - 71000) / PERIODO_US * PERIODO_US;
+    COMPROBAR((int32_t)(t_play_viejo - t_primera) < 0);
+    COMPROBAR(recepcion_profundidad(&r) > 1);
+
+    // Sale en orden de secuencia con t_play no decreciente
+    muestra_t m;
+    uint32_t seq_anterior = 0;
+    uint32_t t_anterior = t_primera;
+    uint32_t extraidas = 0;
+    while (recepcion_extraer(&r, 71000 + 1000000, &m)) {
+        COMPROBAR(m.seq > seq_anterior);
+        COMPROBAR((int32_t)(m.t_play - t_anterior) >= 0);
+        seq_anterior = m.seq;
+        t_anterior = m.t_play;
+        extraidas++;
+    }
+    COMPROBAR(seq_anterior == 20);
+
+    // Todo estado esperado se encola o cuenta como perdido, tardíos incluidos
+    COMPROBAR(r.playout.descartes_tardios > 0);
+    COMPROBAR(r.stats.estados == 1 + LOTE);
+    COMPROBAR(r.stats.perdidos == r.playout.descartes_tardios);
+    COMPROBAR(extraidas + r.stats.perdidos == r.stats.estados);
+}
+
+/**
+ * @brief Ejecuta todas las pruebas.
+ * @return 0 si todas pasan, 1 si alguna falla.
+ */
+int main(void) {
+    prueba_retardo_baja();
+
+    if (fallos) {
+        printf("test_recepcion: %d comprobaciones fallidas\n", fallos);
+        return 1;
+    }
+    printf("test_recepcion: ok\n");
+    return 0;
+}
@@ -11,14 +11,29 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
+#include <math.h>
 
 #include "pico/stdlib.h"
 #include "pico/cyw43_arch.h"
 #include "lwip/udp.h"
 #include "lwip/pbuf.h"
+#include "lwip/igmp.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
 #include "hardware/timer.h" 
+#include "hardware/watchdog.h"
 
 #include "lib/servo/servo.h"
+#include "lib/prediccion/prediccion.h"
+#include "lib/telemetria/telemetria.h"
+#include "lib/conexion/conexion.h"
+#include "lib/arranque/arranque.h"
+#include "lib/reposo/reposo.h"
+#include "lib/planificador/planificador.h"
+#include "lib/perfil/perfil.h"
+#include "lib/memoria/memoria.h"
+#include "lib/recepcion/recepcion.h"
 
 // --- CONFIGURACIÓN WI-FI ---
 /** @brief SSID de la red Wi-Fi (hotspot) a la que se conecta la Pico W. */
@@ -27,6 +42,35 @@
 #define WIFI_PASSWORD "ff11223344"
 /** @brief Puerto UDP en el que escucha el servidor de la mano. */
 #define UDP_PORT      4242
+/**
+ * @brief Grupo multicast al que se une la mano (debe coincidir con el guante).
+ *
+ * La mano acepta a la vez tramas unicast, broadcast y de este grupo, así que
+ * el modo de envío solo se elige en el guante.
+ */
+#define MULTICAST_GRUPO "239.42.42.42"
+/** @brief Timeout del watchdog (ms); el main nunca bloquea, así que se refresca en cada vuelta. */
+#define WATCHDOG_TIMEOUT_MS 5000
+/** @brief 1 para arrancar con la IP de la sesión anterior mientras DHCP confirma (ver lib/ipcache). */
+#define IP_CACHE_HABILITADA 0
+/** @brief Espera máxima a que se abra la consola USB, solo si hay un host conectado (ms). */
+#define USB_ESPERA_MAX_MS   3000
+
+// --- CONFIGURACIÓN DESCUBRIMIENTO ---
+/** @brief Capacidad: tramas `S` con secuencia y redundancia. */
+#define CAP_SECUENCIA   0x01u
+/** @brief Capacidad: lotes de varias muestras por trama. */
+#define CAP_LOTES       0x02u
+/** @brief Capacidad: buffer de reproducción adaptativo. */
+#define CAP_PLAYOUT     0x04u
+/** @brief Capacidad: predicción de latencia. */
+#define CAP_PREDICCION  0x08u
+/** @brief Capacidad: recepción multicast/broadcast. */
+#define CAP_MULTICAST   0x10u
+/** @brief Capacidades anunciadas en la respuesta de descubrimiento. */
+#define CAPACIDADES     (CAP_SECUENCIA | CAP_LOTES | CAP_PLAYOUT | CAP_PREDICCION | CAP_MULTICAST)
+/** @brief Intervalo mínimo entre ACK al guante (ms); el primero sale en cuanto se aplica algo. */
+#define ACK_PERIODO_MS  250
 
 // --- CONFIGURACIÓN MANO ---
 /** @brief Número de dedos controlados por la mano robótica. */
@@ -38,48 +82,110 @@
 /** @brief Índice de dedo cuyo movimiento debe invertirse por montaje físico. */
 #define INVERT_FINGER_INDEX 4          // Ajuste hardware por si un servo está al revés
 
+_Static_assert(NUM_FINGERS == RECEPCION_DEDOS && VMAX == RECEPCION_VMAX, "la trama lleva un dígito por dedo");
+
+// --- CONFIGURACIÓN TRAMA ---
+/** @brief Tamaño máximo de una trama de texto recibida (incluye '\0'). */
+#define TRAMA_MAX_LEN       512
+/** @brief Periodo de impresión de las estadísticas de recepción (ms). */
+#define PERIODO_STATS_MS    5000
+/**
+ * @brief 1 para imprimir cada trama recibida (solo depuración).
+ *
+ * El printf corre dentro del callback UDP, en la IRQ de red, y con 150+ bytes
+ * a 50 Hz domina su tiempo; por eso va apagado salvo con `-DLOG_TRAMAS=ON`.
+ */
+#ifndef LOG_TRAMAS
+#define LOG_TRAMAS          0
+#endif
+
+// --- CONFIGURACIÓN TAREAS ---
+/** @brief Plazo para aplicar una muestra desde su instante de reproducción (µs). */
+#define PLAZO_PLAYOUT_US    1000
+/** @brief Periodo de la tarea de red: conexión Wi-Fi (µs). */
+#define PERIODO_RED_US      10000
+/** @brief Periodo de lectura de la consola serie (µs). */
+#define PERIODO_CONSOLA_US  50000
+/** @brief Plazo para responder una consulta de telemetría (µs). */
+#define PLAZO_TELEMETRIA_US 50000
+/** @brief Plazo para enviar un lote lleno de la traza de servos (µs). */
+#define PLAZO_TRAZA_US      20000
+/** @brief Periodo del parpadeo del LED de heartbeat (µs). */
+#define PERIODO_HEARTBEAT_US 500000
+
+// --- CONFIGURACIÓN PREDICCIÓN ---
+// Ganancias, latencia fija y horizonte máximo: ver lib/prediccion/prediccion.h
+/** @brief Estado inicial del predictor (se alterna en ejecución con la tecla 'p'). */
+#define PREDICCION_HABILITADA       1
+
 /** @brief Estructura del controlador PCA9685 usado para los servomotores. */
 static servo_pca_t servo_dev;
+/** @brief Gestor asíncrono de la conexión Wi-Fi. */
+static conexion_t wifi;
+/** @brief Medida del tiempo en reposo del bucle principal. */
+static reposo_t reposo;
+/** @brief Planificador cooperativo del bucle principal. */
+static planificador_t plan;
+/** @brief Tarea por evento que reproduce la cola; la señala el callback UDP. */
+static int tarea_playout = -1;
 /** @brief PCB UDP usado como servidor para recibir datos desde el guante. */
 static struct udp_pcb *udp_server_pcb = NULL;
+/** @brief Predictor alfa-beta que compensa la latencia de cada dedo. */
+static prediccion_t predictor;
+/** @brief Dirección del último guante que envió tramas (destino de los ACK). */
+static ip_addr_t remitente_ip;
+/** @brief Puerto UDP del último guante que envió tramas. */
+static volatile u16_t remitente_port = 0;
+/** @brief Identificador de esta mano en las estadísticas (su IP). */
+static char id_mano[16] = "?";
+/** @brief Suma de la antigüedad de las muestras al aplicarse en el periodo de estadísticas (µs). */
+static uint64_t latencia_acum_us = 0;
+/** @brief Mayor antigüedad de muestra aplicada en el periodo de estadísticas (µs). */
+static uint32_t latencia_max_us = 0;
+/** @brief Muestras aplicadas en el periodo de estadísticas. */
+static uint32_t aplicadas_periodo = 0;
+/** @brief Muestras aplicadas desde el arranque. */
+static uint32_t aplicadas_total = 0;
+/** @brief Histograma log2 de latencia del periodo de estadísticas en curso. */
+static uint32_t latencia_hist[TELEMETRIA_HIST_BINS];
+/** @brief Histograma de latencia del último periodo cerrado (el que sirve la telemetría). */
+static uint32_t latencia_hist_ultimo[TELEMETRIA_HIST_BINS];
+/** @brief Latencia máxima del último periodo cerrado (µs). */
+static uint32_t latencia_max_ultimo_us = 0;
 
-// --- VARIABLES COMPARTIDAS (VOLATILES PARA IRQ) ---
-/** @brief Indica que se han recibido nuevos datos válidos desde UDP. */
-static volatile bool flag_new_data = false;    
-/** @brief Valores pendientes por aplicar a los dedos, recibidos desde el guante. */
-static volatile int  pending_values[NUM_FINGERS]; 
+/** @brief PCB UDP de telemetría (puerto TELEMETRIA_PORT). */
+static struct udp_pcb *udp_telemetria_pcb = NULL;
+/** @brief Dirección de la última consulta de telemetría pendiente. */
+static ip_addr_t consulta_ip;
+/** @brief Puerto de la última consulta de telemetría pendiente. */
+static u16_t consulta_port = 0;
+/** @brief Snapshots de telemetría servidos. */
+static uint32_t consultas_servidas = 0;
+/** @brief Tarea por evento que arma y envía el snapshot; la señala el callback de telemetría. */
+static int tarea_telemetria = -1;
+/** @brief Suscriptor de la traza de servos (`R?`). */
+static ip_addr_t traza_ip;
+/** @brief Puerto del suscriptor de la traza (0 = sin suscriptor). */
+static volatile u16_t traza_port = 0;
+/** @brief Instante de la última renovación `R?` (ms desde el arranque). */
+static volatile uint32_t t_traza_ms = 0;
+/** @brief Lote de traza en curso (solo lo tocan las tareas del main). */
+static telemetria_traza_lote_t traza_lote;
+/** @brief Tarea por evento que envía el lote de traza. */
+static int tarea_traza = -1;
 
-// --- INTERRUPCIÓN DE TIMER (HEARTBEAT) ---
-/**
- * @brief Callback periódico del timer para generar un "heartbeat" con el LED.
- *
- * Parpadea el LED de la Pico W para indicar que el sistema está en ejecución.
- *
- * @param t Puntero al temporizador que generó la interrupción.
- * @return true para mantener el temporizador repitiéndose.
- */
-bool heartbeat_timer_callback(struct repeating_timer *t) {
-    static bool led_state = false;
-    led_state = !led_state;
-    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, led_state);
-    return true;
-}
+// --- PERFIL (solo builds con PERFIL_HABILITADO) ---
+PERFIL_DEFINIR(perfil_udp_rx_irq, "udp_server_recv");
+PERFIL_DEFINIR(perfil_telemetria_irq, "udp_telem_recv");
+PERFIL_DEFINIR(perfil_poll, "cyw43_poll");
+PERFIL_DEFINIR(perfil_aplicar, "apply_values");
+PERFIL_DEFINIR(perfil_snapshot, "armar_snapshot");
 
-// --- UTILIDADES MATEMÁTICAS ---
-/**
- * @brief Limita un valor entero al rango cerrado [a, b].
- *
- * @param x Valor de entrada.
- * @param a Límite inferior.
- * @param b Límite superior.
- * @return Valor de x recortado al intervalo [a, b].
- */
-static int clampi(int x, int a, int b) {
-    if (x < a) return a;
-    if (x > b) return b;
-    return x;
-}
+// --- VARIABLES COMPARTIDAS (VOLATILES PARA IRQ) ---
+/** @brief Cola de reproducción, secuencia y playout (productor: callback UDP; consumidor: main). */
+static recepcion_t receptor;
 
+// --- UTILIDADES MATEMÁTICAS ---
 /**
  * @brief Convierte un valor del guante a un tiempo en microsegundos para el servo.
  *
@@ -87,24 +193,25 @@ static int clampi(int x, int a, int b) {
  * opcionalmente, invierte la dirección para un dedo específico.
  *
  * @param finger_index Índice del dedo (0 a NUM_FINGERS-1).
- * @param v Valor crudo recibido del guante para ese dedo.
+ * @param v Valor del dedo en unidades del guante (puede ser fraccionario si viene del predictor).
  * @return Ancho de pulso en microsegundos dentro del rango permitido del servo.
  */
-static float value_to_us(int finger_index, int v) {
+static float value_to_us(int finger_index, float v) {
     // 1. Clamping de seguridad
-    v = clampi(v, 0, VMAX);
+    if (v < 0.0f) v = 0.0f;
+    if (v > (float)VMAX) v = (float)VMAX;
     
     // 2. Corrección de "Piso" (Offset)
     // Si llega un valor < 2, lo tratamos como 2 para evitar valores negativos en la norma
-    int v_adjusted = v;
-    if (v_adjusted < SENSOR_FLOOR) v_adjusted = SENSOR_FLOOR;
+    float v_adjusted = v;
+    if (v_adjusted < (float)SENSOR_FLOOR) v_adjusted = (float)SENSOR_FLOOR;
     
     // 3. Normalización
     float range_span = (float)(VMAX - SENSOR_FLOOR);
     if (range_span < 1.0f) range_span = 1.0f;
 
     // Calculamos porcentaje de 0.0 a 1.0
-    float norm = ((float)v_adjusted - (float)SENSOR_FLOOR) / range_span;
+    float norm = (v_adjusted - (float)SENSOR_FLOOR) / range_span;
     
     // 4. Inversión Hardware Específica (Solo si un dedo físico está montado al revés)
     if (finger_index == INVERT_FINGER_INDEX) {
@@ -122,7 +229,8 @@ static float value_to_us(int finger_index, int v) {
  *
  * @param v Arreglo de tamaño NUM_FINGERS con los valores de cada dedo.
  */
-static void apply_values_logic(const int v[NUM_FINGERS]) {
+static void apply_values_logic(const float v[NUM_FINGERS]) {
+    PERFIL_SONDA(perfil_aplicar);
     for (int i = 0; i < NUM_FINGERS; i++) {
         float us = value_to_us(i, v[i]);
         servo_set_us(&servo_dev, (uint8_t)i, us);
@@ -130,33 +238,103 @@ static void apply_values_logic(const int v[NUM_FINGERS]) {
 }
 
 /**
- * @brief Parsea una trama recibida del guante en formato CSV.
+ * @brief Imprime las estadísticas de recepción, pérdida efectiva y latencia de esta mano.
+ *
+ * Cada mano lleva sus propias estadísticas, así que con el guante en modo
+ * multicast/broadcast se puede comparar cómo escala el aire compartido.
+ */
+static void imprimir_stats(void) {
+    uint32_t estados = receptor.stats.estados ? receptor.stats.estados : 1;
+    uint32_t aplicadas = aplicadas_periodo ? aplicadas_periodo : 1;
+    printf("[MANO %s] perdida=%.2f%% latencia_media=%luus latencia_max=%luus aplicadas=%lu\n",
+           id_mano, 100.0f * (float)receptor.stats.perdidos / (float)estados,
+           (uint32_t)(latencia_acum_us / aplicadas), latencia_max_us, aplicadas_periodo);
+    // Cerrar el periodo: la telemetría sirve el último histograma completo
+    memcpy(latencia_hist_ultimo, latencia_hist, sizeof(latencia_hist));
+    memset(latencia_hist, 0, sizeof(latencia_hist));
+    latencia_max_ultimo_us = latencia_max_us;
+    latencia_acum_us = 0;
+    latencia_max_us = 0;
+    aplicadas_periodo = 0;
+
+    printf("[RX] tramas=%lu bytes=%lu invalidas=%lu estados=%lu recuperados=%lu "
+           "perdidos=%lu (%.2f%%) desbordes=%lu saltados=%lu reinicios=%lu\n",
+           receptor.stats.tramas, receptor.stats.bytes, receptor.stats.invalidas, receptor.stats.estados,
+           receptor.stats.recuperados, receptor.stats.perdidos,
+           100.0f * (float)receptor.stats.perdidos / (float)estados, receptor.stats.desbordes,
+           receptor.stats.saltados, receptor.stats.reinicios);
+    printf("[PLAYOUT] profundidad=%lu retardo=%ldus objetivo=%ldus jitter=%ld/%ldus "
+           "descartes_tardios=%lu\n",
+           recepcion_profundidad(&receptor), receptor.playout.retardo_us, receptor.playout.objetivo_us,
+           receptor.playout.espera_media_us, receptor.playout.espera_desv_us, receptor.playout.descartes_tardios);
+    printf("[PRED] habilitada=%d horizonte=%luus error_medio=%.3f\n",
+           predictor.habilitada, predictor.horizonte_us, prediccion_error_medio(&predictor));
+    printf("[I2C] errores=%lu reintentos=%lu\n", servo_dev.errores_i2c, servo_dev.reintentos_i2c);
+    conexion_imprimir(&wifi);
+    reposo_imprimir(&reposo);
+}
+
+// --- DESCUBRIMIENTO Y ACK ---
+/**
+ * @brief Envía un texto corto por UDP a una dirección.
  *
- * Se espera una línea con el formato: `H,d0,d1,d2,d3,d4`.
+ * Debe llamarse con la pila lwIP bloqueada (desde un callback o entre
+ * cyw43_arch_lwip_begin/end).
  *
- * @param line Cadena recibida vía UDP.
- * @param out_vals Arreglo de salida (tamaño NUM_FINGERS) con los valores parseados.
- * @return true si la trama es válida y se llenó out_vals, false en caso contrario.
+ * @param texto Cadena terminada en '\0'.
+ * @param ip Dirección IP de destino.
+ * @param port Puerto UDP de destino.
  */
-static bool parse_trama(char *line, int out_vals[NUM_FINGERS]) {
-    if (line[0] != 'H') return false;
-    
-    int v[5];
-    int read_count = sscanf(line, "H,%d,%d,%d,%d,%d", 
-                            &v[0], &v[1], &v[2], &v[3], &v[4]);
-    
-    if (read_count != 5) return false;
+static void enviar_texto(const char *texto, const ip_addr_t *ip, u16_t port) {
+    u16_t len = (u16_t)strlen(texto);
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+    if (!p) return;
+    memcpy(p->payload, texto, len);
+    udp_sendto(udp_server_pcb, p, ip, port);
+    pbuf_free(p);
+}
+
+/**
+ * @brief Responde a una sonda de descubrimiento `D?` con la IP y capacidades de la mano.
+ *
+ * Formato: `D!,<ip>,<puerto>,<caps>` con caps en hexadecimal (ver CAP_*).
+ *
+ * @param addr Dirección del guante que envió la sonda.
+ * @param port Puerto de origen de la sonda.
+ */
+static void responder_descubrimiento(const ip_addr_t *addr, u16_t port) {
+    char respuesta[48];
+    snprintf(respuesta, sizeof(respuesta), "D!,%s,%d,0x%02x",
+             ip4addr_ntoa(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA])), UDP_PORT,
+             (unsigned)CAPACIDADES);
+    enviar_texto(respuesta, addr, port);
+}
 
-    for(int i=0; i<5; i++) out_vals[i] = v[i];
-    return true;
+/**
+ * @brief Envía al guante un ACK `A,<seq>` con la última secuencia aplicada.
+ *
+ * El guante lo usa para detectar que la mano sigue recibiendo y, si deja de
+ * llegar, redescubrirla.
+ *
+ * @param seq Secuencia de la última muestra aplicada.
+ */
+static void enviar_ack(uint32_t seq) {
+    if (remitente_port == 0) return;
+    char ack[16];
+    snprintf(ack, sizeof(ack), "A,%lu", (unsigned long)seq);
+    cyw43_arch_lwip_begin();
+    enviar_texto(ack, &remitente_ip, remitente_port);
+    cyw43_arch_lwip_end();
 }
 
 // --- CALLBACK UDP (EVENTO) ---
 /**
  * @brief Callback de recepción UDP para procesar tramas del guante.
  *
- * Copia la carga útil a un buffer local, intenta parsear la trama y, si es válida,
- * actualiza los valores pendientes y levanta la bandera @ref flag_new_data.
+ * Responde directamente a las sondas de descubrimiento. Para las tramas,
+ * copia la carga útil a un buffer local, intenta parsearla y, si es válida,
+ * encola los estados nuevos (incluidos los recuperados por redundancia) con su
+ * instante de reproducción para el main y recuerda al remitente para los ACK.
  *
  * @param arg Puntero opcional de usuario (no usado).
  * @param pcb PCB UDP que recibe los datos.
@@ -166,74 +344,461 @@ static bool parse_trama(char *line, int out_vals[NUM_FINGERS]) {
  */
 static void udp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
                             const ip_addr_t *addr, u16_t port) {
+    PERFIL_SONDA(perfil_udp_rx_irq);
     if (!p) return;
 
-    char buffer[64];
-    u16_t len = p->len > 63 ? 63 : p->len;
-    memcpy(buffer, p->payload, len);
+    uint32_t llegada_us = time_us_32();
+
+    // Estáticos: no caben con holgura en la pila de la IRQ de red
+    static char buffer[TRAMA_MAX_LEN];
+    static trama_t trama;
+    u16_t len = pbuf_copy_partial(p, buffer, TRAMA_MAX_LEN - 1, 0);
     buffer[len] = '\0';
 
-    int vals[NUM_FINGERS];
-    if (parse_trama(buffer, vals)) {
-        // Copia atómica a variables compartidas
-        for(int i=0; i<NUM_FINGERS; i++) {
-            pending_values[i] = vals[i];
-        }
-        flag_new_data = true; // Notificar al Main
+    if (buffer[0] == 'D' && buffer[1] == '?') {
+        responder_descubrimiento(addr, port);
+    } else if (recepcion_parsear(buffer, &trama)) {
+        receptor.stats.tramas++;
+        receptor.stats.bytes += len;
+        ip_addr_copy(remitente_ip, *addr);
+        remitente_port = port;
+        recepcion_procesar(&receptor, &trama, llegada_us); // Notifica al Main a través de la cola
+#if LOG_TRAMAS
         printf("%s\n", buffer);
+#endif
+    } else {
+        receptor.stats.invalidas++;
     }
 
     pbuf_free(p);
+    planificador_senalar(&plan, tarea_playout);
+    __sev(); // Despierta al main si estaba en reposo
+}
+
+// --- TELEMETRÍA ---
+/**
+ * @brief Callback de recepción del puerto de telemetría.
+ *
+ * Ante `T?` solo recuerda quién pregunta y señala la tarea de telemetría: el
+ * snapshot se arma en el main a partir de contadores que ya existen, así que
+ * una consulta no añade trabajo a la IRQ de red. Ante `R?` suscribe al
+ * remitente a la traza de servos durante TELEMETRIA_TRAZA_TIMEOUT_MS.
+ *
+ * @param arg Puntero opcional de usuario (no usado).
+ * @param pcb PCB UDP que recibe los datos.
+ * @param p Estructura pbuf con la carga útil recibida.
+ * @param addr Dirección IP del emisor.
+ * @param port Puerto UDP de origen.
+ */
+static void udp_telemetria_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                                const ip_addr_t *addr, u16_t port) {
+    PERFIL_SONDA(perfil_telemetria_irq);
+    if (!p) return;
+    char consulta[2] = { 0 };
+    pbuf_copy_partial(p, consulta, sizeof(consulta), 0);
+    pbuf_free(p);
+
+    if (consulta[1] != '?') return;
+    if (consulta[0] == 'T') {
+        ip_addr_copy(consulta_ip, *addr);
+        consulta_port = port;
+        planificador_senalar(&plan, tarea_telemetria);
+    } else if (consulta[0] == 'R') {
+        // Suscribe (o renueva) la traza de servos y vacía lo pendiente
+        ip_addr_copy(traza_ip, *addr);
+        traza_port = port;
+        t_traza_ms = to_ms_since_boot(get_absolute_time());
+        planificador_senalar(&plan, tarea_traza);
+    } else {
+        return;
+    }
+    __sev(); // Despierta al main si estaba en reposo
+}
+
+/**
+ * @brief Copia el uso de un pool de lwIP al formato de telemetría.
+ * @param out Pool de telemetría.
+ * @param in  Estadísticas de lwIP (puede ser NULL si el pool no existe).
+ */
+static void copiar_pool(telemetria_pool_t *out, const struct stats_mem *in) {
+    if (!in) return;
+    out->usado = (uint16_t)in->used;
+    out->maximo = (uint16_t)in->max;
+    out->disponible = (uint16_t)in->avail;
+    out->errores = (uint16_t)in->err;
+}
+
+/**
+ * @brief Arma el snapshot de telemetría con los contadores actuales.
+ * @param t Snapshot a rellenar.
+ */
+static void armar_snapshot(telemetria_snapshot_t *t) {
+    PERFIL_SONDA(perfil_snapshot);
+    memset(t, 0, sizeof(*t));
+    t->magia = TELEMETRIA_MAGIA;
+    t->version = TELEMETRIA_VERSION;
+    t->tamano = sizeof(*t);
+    t->uptime_ms = to_ms_since_boot(get_absolute_time());
+    t->consultas = ++consultas_servidas;
+
+    t->tramas = receptor.stats.tramas;
+    t->bytes = receptor.stats.bytes;
+    t->invalidas = receptor.stats.invalidas;
+    t->estados = receptor.stats.estados;
+    t->recuperados = receptor.stats.recuperados;
+    t->perdidos = receptor.stats.perdidos;
+    t->desbordes = receptor.stats.desbordes;
+    t->saltados = receptor.stats.saltados;
+    t->descartes_tardios = receptor.playout.descartes_tardios;
+    t->aplicadas = aplicadas_total;
+
+    t->i2c_errores = servo_dev.errores_i2c;
+    t->i2c_reintentos = servo_dev.reintentos_i2c;
+
+    memcpy(t->latencia_hist, latencia_hist_ultimo, sizeof(t->latencia_hist));
+    t->latencia_max_us = latencia_max_ultimo_us;
+    t->playout_retardo_us = receptor.playout.retardo_us;
+    t->playout_jitter_us = receptor.playout.espera_desv_us;
+
+    t->reposo_permil = (uint16_t)(1000.0f * reposo_fraccion(&reposo));
+    t->num_tareas = (uint8_t)(plan.num_tareas < TELEMETRIA_MAX_TAREAS ? plan.num_tareas : TELEMETRIA_MAX_TAREAS);
+    for (uint32_t i = 0; i < t->num_tareas; i++) {
+        const tarea_t *tarea = &plan.tareas[i];
+        strncpy(t->tareas[i].nombre, tarea->nombre, TELEMETRIA_NOMBRE_LEN);
+        t->tareas[i].ejecuciones = tarea->ejecuciones;
+        t->tareas[i].exec_max_us = tarea->exec_max_us;
+        t->tareas[i].retraso_max_us = tarea->retraso_max_us;
+        t->tareas[i].plazos_perdidos = tarea->plazos_perdidos;
+    }
+
+    copiar_pool(&t->heap, &lwip_stats.mem);
+    copiar_pool(&t->pbuf_pool, lwip_stats.memp[MEMP_PBUF_POOL]);
+    copiar_pool(&t->pbuf_ref, lwip_stats.memp[MEMP_PBUF]);
+    copiar_pool(&t->udp_pcb, lwip_stats.memp[MEMP_UDP_PCB]);
+
+    t->wifi_caidas = wifi.caidas;
+    t->wifi_reconexion_ms = wifi.ultima_reconexion_ms;
+}
+
+// --- TAREAS ---
+/**
+ * @brief Tarea de telemetría: responde la última consulta `T?` con un snapshot binario.
+ * @param ctx No usado.
+ */
+static void tarea_telemetria_fn(void *ctx) {
+    static telemetria_snapshot_t snapshot;
+
+    // Bajo el bloqueo de lwIP: el callback no puede cambiar el destino a medias
+    cyw43_arch_lwip_begin();
+    armar_snapshot(&snapshot);
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, sizeof(snapshot), PBUF_RAM);
+    if (p) {
+        memcpy(p->payload, &snapshot, sizeof(snapshot));
+        udp_sendto(udp_telemetria_pcb, p, &consulta_ip, consulta_port);
+        pbuf_free(p);
+    }
+    cyw43_arch_lwip_end();
+}
+
+_Static_assert(NUM_FINGERS == TELEMETRIA_TRAZA_DEDOS, "la traza lleva un valor por dedo");
+
+/**
+ * @brief Indica si hay un suscriptor de la traza con la suscripción vigente.
+ * @return true si se deben registrar las actualizaciones de los servos.
+ */
+static bool traza_activa(void) {
+    return traza_port != 0 &&
+           to_ms_since_boot(get_absolute_time()) - t_traza_ms < TELEMETRIA_TRAZA_TIMEOUT_MS;
+}
+
+/**
+ * @brief Añade una actualización de los servos al lote de traza.
+ *
+ * Solo si hay suscriptor; con el lote lleno señala la tarea que lo envía.
+ *
+ * @param v   Valores enviados a cada dedo (0–9).
+ * @param seq Secuencia de la muestra más reciente aplicada.
+ */
+static void traza_registrar(const float v[NUM_FINGERS], uint32_t seq) {
+    if (!traza_activa()) return;
+    if (traza_lote.n >= TELEMETRIA_TRAZA_LOTE) {
+        traza_lote.descartados++;
+        return;
+    }
+    telemetria_traza_t *r = &traza_lote.registros[traza_lote.n++];
+    r->t_us = time_us_32();
+    r->seq = seq;
+    for (int i = 0; i < NUM_FINGERS; i++) {
+        r->valor_c[i] = (int16_t)lroundf(v[i] * 100.0f);
+        r->pwm_off[i] = servo_dev.off[i];
+    }
+    if (traza_lote.n == TELEMETRIA_TRAZA_LOTE) planificador_senalar(&plan, tarea_traza);
+}
+
+/**
+ * @brief Tarea de traza: envía al suscriptor los registros acumulados.
+ *
+ * La señalan el lote lleno y cada renovación `R?`, que así vacía lo
+ * pendiente aunque la mano deje de recibir tramas.
+ *
+ * @param ctx No usado.
+ */
+static void tarea_traza_fn(void *ctx) {
+    if (!traza_activa()) {
+        traza_lote.n = 0;
+        traza_lote.descartados = 0;
+        return;
+    }
+    if (traza_lote.n == 0) return;
+
+    traza_lote.magia = TELEMETRIA_TRAZA_MAGIA;
+    traza_lote.version = TELEMETRIA_VERSION;
+    traza_lote.t_envio_us = time_us_32();
+    u16_t len = (u16_t)(offsetof(telemetria_traza_lote_t, registros) +
+                        traza_lote.n * sizeof(telemetria_traza_t));
+
+    cyw43_arch_lwip_begin();
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+    if (p) {
+        memcpy(p->payload, &traza_lote, len);
+        udp_sendto(udp_telemetria_pcb, p, &traza_ip, traza_port);
+        pbuf_free(p);
+    }
+    cyw43_arch_lwip_end();
+    traza_lote.n = 0;
+}
+
+/** @brief Instante a partir del cual se puede enviar el próximo ACK. */
+static absolute_time_t proximo_ack;
+/** @brief Ya se envió un ACK desde la última (re)conexión. */
+static bool ack_enviado = false;
+
+/**
+ * @brief Tarea de reproducción: aplica las muestras ya vencidas de la cola.
+ *
+ * El paso es recepcion_reproducir(), el mismo que usa Pico_Host/reproductor:
+ * todas alimentan al predictor, pero solo la más reciente llega a los servos.
+ * La señala el callback UDP al llegar una trama y se reprograma sola para el
+ * instante de la siguiente muestra de la cola.
+ *
+ * @param ctx No usado.
+ */
+static void tarea_playout_fn(void *ctx) {
+    static bool primer_frame_marcado = false;
+
+    reproduccion_t rep;
+    bool aplicar = recepcion_reproducir(&receptor, &predictor, time_us_32(), &rep);
+    // La siguiente muestra marca la próxima activación
+    if (rep.programada) planificador_programar(&plan, tarea_playout, rep.t_proxima);
+    if (!aplicar) return;
+
+    // Latencia medida: antigüedad de la muestra al llegar a los servos
+    latencia_acum_us += rep.antiguedad_us;
+    if (rep.antiguedad_us > latencia_max_us) latencia_max_us = rep.antiguedad_us;
+    telemetria_hist_agregar(latencia_hist, rep.antiguedad_us);
+    aplicadas_periodo++;
+    aplicadas_total++;
+
+    apply_values_logic(rep.valores);
+    traza_registrar(rep.valores, rep.seq);
+    if (!primer_frame_marcado) {
+        primer_frame_marcado = true;
+        arranque_marcar("primer_frame");
+    }
+
+    // ACK al guante: el primero sale en cuanto se aplica algo
+    if (!ack_enviado || absolute_time_diff_us(proximo_ack, get_absolute_time()) >= 0) {
+        enviar_ack(rep.seq);
+        ack_enviado = true;
+        proximo_ack = make_timeout_time_ms(ACK_PERIODO_MS);
+    }
+}
+
+/**
+ * @brief Tarea de red: avanza la conexión Wi-Fi y reacciona a conexiones y caídas.
+ * @param ctx No usado.
+ */
+static void tarea_red_fn(void *ctx) {
+    static bool igmp_unido = false;
+
+    switch (conexion_tick(&wifi)) {
+    case CONEXION_EVENTO_CONECTADO:
+        if (wifi.conexiones == 1) arranque_marcar("wifi_ip");
+        snprintf(id_mano, sizeof(id_mano), "%s", ip4addr_ntoa(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA])));
+        printf("IP SERVER: %s\n", id_mano);
+        conexion_imprimir(&wifi);
+        ack_enviado = false; // Avisar al guante en cuanto vuelva a llegar algo
+
+        // Unirse al grupo multicast del guante (una trama alimenta a N manos).
+        // La pertenencia vive en la netif y sobrevive a las reconexiones.
+        if (!igmp_unido) {
+            ip4_addr_t grupo;
+            ip4addr_aton(MULTICAST_GRUPO, &grupo);
+            cyw43_arch_lwip_begin();
+            igmp_unido = igmp_joingroup_netif(&cyw43_state.netif[CYW43_ITF_STA], &grupo) == ERR_OK;
+            cyw43_arch_lwip_end();
+            if (!igmp_unido) printf("Error IGMP %s\n", MULTICAST_GRUPO);
+        }
+        break;
+    case CONEXION_EVENTO_IP_CAMBIADA:
+        // DHCP no confirmó la IP en caché: el guante la redescubre al faltarle los ACK
+        snprintf(id_mano, sizeof(id_mano), "%s", ip4addr_ntoa(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA])));
+        printf("IP SERVER (DHCP): %s\n", id_mano);
+        ack_enviado = false;
+        break;
+    case CONEXION_EVENTO_CAIDA:
+        printf("WiFi caido, reconectando (los servos mantienen la pose)\n");
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Tarea de consola.
+ *
+ * - 'p' alterna la predicción para comparar el error de seguimiento.
+ * - 't' vuelca y reinicia los tiempos por sección (lib/perfil).
+ *
+ * @param ctx No usado.
+ */
+static void tarea_consola_fn(void *ctx) {
+    switch (getchar_timeout_us(0)) {
+    case 'p':
+        prediccion_habilitar(&predictor, !predictor.habilitada);
+        printf("[PRED] habilitada=%d\n", predictor.habilitada);
+        break;
+    case 't':
+        perfil_imprimir();
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Tarea de estadísticas: pérdida, playout, predicción, red, CPU, tareas y memoria.
+ * @param ctx No usado.
+ */
+static void tarea_stats_fn(void *ctx) {
+    imprimir_stats();
+    planificador_imprimir(&plan);
+    memoria_imprimir();
+}
+
+/**
+ * @brief Tarea de heartbeat: parpadea el LED de la Pico W para indicar que el sistema está en ejecución.
+ *
+ * Antes era un repeating_timer en IRQ; como tarea no toca el chip Wi-Fi desde
+ * una interrupción.
+ *
+ * @param ctx No usado.
+ */
+static void tarea_heartbeat_fn(void *ctx) {
+    static bool led_state = false;
+    led_state = !led_state;
+    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, led_state);
 }
 
 // --- MAIN ---
 /**
  * @brief Punto de entrada del servidor de la mano robótica.
  *
- * Inicializa UART/STDIO, Wi-Fi, el controlador de servos, configura el servidor
- * UDP y un timer de heartbeat. En el bucle principal, realiza polling de Wi-Fi
- * y aplica nuevos valores de dedos cuando llegan tramas válidas.
+ * Inicializa primero el controlador de servos y aparca la mano en posición
+ * segura; después el chip Wi-Fi, la conexión asíncrona, el servidor UDP y el
+ * watchdog. Solo espera al USB si hay un host conectado, y registra cada fase
+ * en la traza de arranque. El bucle principal ejecuta las tareas listas por
+ * prioridad (reproducción, red, consola, estadísticas, heartbeat) y, sin
+ * trabajo, duerme en WFE hasta la próxima activación o IRQ.
  *
- * @return 0 en funcionamiento normal, 1 en caso de error de inicialización.
+ * @return No retorna; si el chip Wi-Fi no inicia, reinicia la placa.
  */
 int main() {
+    // Antes que nada: lo que quede sin pintar es uso real de la pila
+    memoria_pintar_pilas();
     stdio_init_all();
-    sleep_ms(3000);
-    printf("=== SERVER (MANO): Lógica Directa ===\n");
+    arranque_marcar("stdio");
+
+    // Servos primero: la mano queda quieta en posición segura antes de lo lento
+    bool servos_ok = servo_init(&servo_dev);
+    const float pose_reposo[NUM_FINGERS] = { 0 }; // 0 = dedo abierto
+    apply_values_logic(pose_reposo);
+    arranque_marcar("servos");
+
+    // Tareas del bucle principal (0 = mayor prioridad)
+    planificador_init(&plan, time_us_32);
+    tarea_playout = planificador_evento(&plan, "playout", tarea_playout_fn, NULL, 0, PLAZO_PLAYOUT_US);
+    planificador_periodica(&plan, "red", tarea_red_fn, NULL, 1, PERIODO_RED_US);
+    planificador_periodica(&plan, "consola", tarea_consola_fn, NULL, 2, PERIODO_CONSOLA_US);
+    tarea_telemetria = planificador_evento(&plan, "telemetria", tarea_telemetria_fn, NULL, 2, PLAZO_TELEMETRIA_US);
+    tarea_traza = planificador_evento(&plan, "traza", tarea_traza_fn, NULL, 2, PLAZO_TRAZA_US);
+    planificador_periodica(&plan, "stats", tarea_stats_fn, NULL, 3, PERIODO_STATS_MS * 1000u);
+    planificador_periodica(&plan, "heartbeat", tarea_heartbeat_fn, NULL, 3, PERIODO_HEARTBEAT_US);
 
-    if (cyw43_arch_init()) return 1;
+    // Secciones medidas (sin efecto si el perfil está deshabilitado)
+    PERFIL_REGISTRAR(perfil_udp_rx_irq);
+    PERFIL_REGISTRAR(perfil_telemetria_irq);
+    PERFIL_REGISTRAR(perfil_poll);
+    PERFIL_REGISTRAR(perfil_aplicar);
+    PERFIL_REGISTRAR(perfil_snapshot);
+
+    if (cyw43_arch_init()) {
+        // Sin chip Wi-Fi no hay nada que hacer: reiniciar en lugar de quedar muerto
+        printf("Fallo cyw43, reiniciando\n");
+        watchdog_reboot(0, 0, 100);
+        while (1) tight_loop_contents();
+    }
     cyw43_wifi_pm(&cyw43_state, CYW43_NO_POWERSAVE_MODE);
     cyw43_arch_enable_sta_mode();
+    arranque_marcar("cyw43");
 
-    if (cyw43_arch_wifi_connect_timeout_ms(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK, 15000)) {
-        printf("Fallo WiFi\n");
-        return 1;
-    }
-    printf("IP SERVER: %s\n", ip4addr_ntoa(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA])));
+    // Conexión asíncrona: la asociación avanza en segundo plano
+    conexion_init(&wifi, WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK);
+    conexion_usar_ip_cache(&wifi, IP_CACHE_HABILITADA);
+    conexion_tick(&wifi);
+    arranque_marcar("wifi_async");
 
-    if (!servo_init(&servo_dev)) printf("Error PCA9685\n");
+    recepcion_init(&receptor);
+    prediccion_init(&predictor, NUM_FINGERS, PREDICCION_ALPHA, PREDICCION_BETA, (float)VMAX);
+    prediccion_habilitar(&predictor, PREDICCION_HABILITADA);
 
     udp_server_pcb = udp_new_ip_type(IPADDR_TYPE_V4);
     udp_bind(udp_server_pcb, IP_ANY_TYPE, UDP_PORT);
     udp_recv(udp_server_pcb, udp_server_recv, NULL);
 
-    // Timer Heartbeat (Interrupción)
-    struct repeating_timer timer;
-    add_repeating_timer_ms(500, heartbeat_timer_callback, NULL, &timer);
+    udp_telemetria_pcb = udp_new_ip_type(IPADDR_TYPE_V4);
+    udp_bind(udp_telemetria_pcb, IP_ANY_TYPE, TELEMETRIA_PORT);
+    udp_recv(udp_telemetria_pcb, udp_telemetria_recv, NULL);
+    arranque_marcar("udp");
 
-    // Bucle Principal (Polling)
-    while (1) {
-        // 1. Polling WiFi
-        cyw43_arch_poll();
+    // Sin host USB (batería) no se espera; con host, hasta que abra la consola
+    arranque_esperar_usb(USB_ESPERA_MAX_MS);
+    arranque_marcar("usb");
+
+    printf("=== SERVER (MANO): Lógica Directa ===\n");
+    if (!servos_ok) printf("Error PCA9685\n");
+    arranque_imprimir();
+
+    // Nada bloquea a partir de aquí: el watchdog se refresca en cada vuelta
+    watchdog_enable(WATCHDOG_TIMEOUT_MS, true);
+    arranque_marcar("loop");
+    reposo_init(&reposo);
 
-        // 2. Polling Lógica Aplicación
-        if (flag_new_data) {
-            flag_new_data = false;
-            
-            int current_vals[NUM_FINGERS];
-            for(int i=0; i<NUM_FINGERS; i++) current_vals[i] = pending_values[i];
+    // Bucle Principal (Planificador)
+    while (1) {
+        watchdog_update();
 
-            apply_values_logic(current_vals);
+        // Polling WiFi (no-op con threadsafe_background; necesario con la variante poll)
+        {
+            PERFIL_SONDA(perfil_poll);
+            cyw43_arch_poll();
         }
+
+        // Una tarea por vuelta: tras cada una se vuelve a elegir por prioridad
+        if (planificador_ejecutar(&plan)) continue;
+
+        // Sin tareas listas: dormir hasta la próxima activación (p. ej. la
+        // siguiente muestra de la cola) o la próxima IRQ (red, USB)
+        reposo_esperar(&reposo, make_timeout_time_us(planificador_espera_us(&plan)));
     }
 }
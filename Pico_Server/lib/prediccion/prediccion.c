@@ -0,0 +1,136 @@
+/**
+ * @file prediccion.c
+ * @brief Implementación del predictor alfa-beta por dedo.
+ *
+ * No depende del hardware: puede compilarse en el PC para reproducir sesiones
+ * grabadas y comparar el error de seguimiento con y sin predicción.
+ */
+
+#include "prediccion.h"
+
+#include <string.h>
+
+/**
+ * @brief Limita un valor real al intervalo [a, b].
+ * @param x Valor original.
+ * @param a Límite inferior.
+ * @param b Límite superior.
+ * @return Valor recortado.
+ */
+static float clampf(float x, float a, float b) {
+    if (x < a) return a;
+    if (x > b) return b;
+    return x;
+}
+
+/**
+ * @brief Compara con una medida las salidas cuyo instante objetivo ya pasó.
+ * @param p    Predictor.
+ * @param t_us Instante de la medida.
+ */
+static void evaluar_salidas(prediccion_t *p, uint32_t t_us) {
+    while (p->salidas_tail != p->salidas_head) {
+        const prediccion_salida_t *s = &p->salidas[p->salidas_tail % PREDICCION_HISTORIAL];
+        if ((int32_t)(t_us - s->t_objetivo_us) < 0) break;
+
+        for (uint8_t i = 0; i < p->num_dedos; i++) {
+            float e = s->valor[i] - p->medida[i];
+            p->error_acum += (e < 0.0f) ? -e : e;
+        }
+        p->error_muestras += p->num_dedos;
+        p->salidas_tail++;
+    }
+}
+
+/**
+ * @brief Inicializa el predictor con las ganancias dadas y la predicción activa.
+ * @param p         Predictor a inicializar.
+ * @param num_dedos Número de dedos (máximo PREDICCION_MAX_DEDOS).
+ * @param alpha     Ganancia de posición.
+ * @param beta      Ganancia de velocidad.
+ * @param vmax      Valor máximo de salida.
+ */
+void prediccion_init(prediccion_t *p, uint8_t num_dedos, float alpha, float beta, float vmax) {
+    memset(p, 0, sizeof(*p));
+    p->num_dedos = (num_dedos > PREDICCION_MAX_DEDOS) ? PREDICCION_MAX_DEDOS : num_dedos;
+    p->alpha = alpha;
+    p->beta = beta;
+    p->vmax = vmax;
+    p->habilitada = true;
+}
+
+/**
+ * @brief Activa o desactiva la proyección y reinicia el error de seguimiento.
+ * @param p          Predictor.
+ * @param habilitada true para proyectar, false para entregar la última medida.
+ */
+void prediccion_habilitar(prediccion_t *p, bool habilitada) {
+    p->habilitada = habilitada;
+    p->salidas_tail = p->salidas_head;
+    p->error_acum = 0.0f;
+    p->error_muestras = 0;
+}
+
+/**
+ * @brief Actualiza el filtro alfa-beta con una medida de todos los dedos.
+ * @param p       Predictor.
+ * @param medidas Valor medido de cada dedo.
+ * @param t_us    Instante de muestreo de la medida.
+ */
+void prediccion_actualizar(prediccion_t *p, const float medidas[], uint32_t t_us) {
+    uint32_t dt_us = t_us - p->t_ultima_us;
+
+    // Primera medida o hueco demasiado largo: reiniciar sin velocidad
+    if (!p->iniciado || dt_us == 0 || dt_us > PREDICCION_DT_MAX_US) {
+        for (uint8_t i = 0; i < p->num_dedos; i++) {
+            p->x[i] = medidas[i];
+            p->v[i] = 0.0f;
+        }
+        p->iniciado = true;
+    } else {
+        float dt = (float)dt_us * 1e-6f;
+        for (uint8_t i = 0; i < p->num_dedos; i++) {
+            float x_pred = p->x[i] + p->v[i] * dt;
+            float r = medidas[i] - x_pred;
+            p->x[i] = x_pred + p->alpha * r;
+            p->v[i] += (p->beta / dt) * r;
+        }
+    }
+
+    memcpy(p->medida, medidas, p->num_dedos * sizeof(float));
+    p->t_ultima_us = t_us;
+    evaluar_salidas(p, t_us);
+}
+
+/**
+ * @brief Proyecta cada dedo un horizonte hacia adelante y recorta a [0, vmax].
+ * @param p            Predictor.
+ * @param horizonte_us Latencia a compensar desde la última medida (µs).
+ * @param[out] out     Valor de cada dedo.
+ */
+void prediccion_salida(prediccion_t *p, uint32_t horizonte_us, float out[]) {
+    float h = (float)horizonte_us * 1e-6f;
+
+    for (uint8_t i = 0; i < p->num_dedos; i++) {
+        float y = p->habilitada ? p->x[i] + p->v[i] * h : p->medida[i];
+        out[i] = clampf(y, 0.0f, p->vmax);
+    }
+    p->horizonte_us = horizonte_us;
+
+    // Guardar la salida; si el historial está lleno se pierde la más antigua
+    if (p->salidas_head - p->salidas_tail >= PREDICCION_HISTORIAL) p->salidas_tail++;
+    prediccion_salida_t *s = &p->salidas[p->salidas_head % PREDICCION_HISTORIAL];
+    s->t_objetivo_us = p->t_ultima_us + horizonte_us;
+    memcpy(s->valor, out, p->num_dedos * sizeof(float));
+    p->salidas_head++;
+}
+
+/**
+ * @brief Error medio absoluto de seguimiento desde el último reinicio.
+ * @param p Predictor.
+ * @return Error medio en unidades del guante.
+ */
+float prediccion_error_medio(const prediccion_t *p) {
+    if (p->error_muestras == 0) return 0.0f;
+    return p->error_acum / (float)p->error_muestras;
+}
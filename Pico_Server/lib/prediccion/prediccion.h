@@ -0,0 +1,112 @@
+/**
+ * @file prediccion.h
+ * @brief Predictor alfa-beta por dedo para compensar la latencia del sistema.
+ */
+
+#ifndef PREDICCION_H
+#define PREDICCION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Número máximo de dedos que maneja el predictor. */
+#define PREDICCION_MAX_DEDOS    5
+/** Salidas recordadas para medir el error de seguimiento. */
+#define PREDICCION_HISTORIAL    32
+/** Separación máxima entre medidas antes de reiniciar el filtro (µs). */
+#define PREDICCION_DT_MAX_US    500000u
+
+/** @brief Ganancia de posición por defecto (ajustada para muestras cada 2 ms con entradas 0–9). */
+#define PREDICCION_ALPHA            0.05f
+/** @brief Ganancia de velocidad por defecto (ajustada para muestras cada 2 ms con entradas 0–9). */
+#define PREDICCION_BETA             0.003f
+/**
+ * @brief Latencia no medible que se suma al horizonte (µs).
+ *
+ * Cubre el tránsito mínimo de red (absorbido por el offset de reloj) y la
+ * respuesta del servo (un periodo PWM de 20 ms más la mecánica).
+ */
+#define PREDICCION_LATENCIA_FIJA_US 30000u
+/** @brief Horizonte máximo de proyección (µs) para no extrapolar de más. */
+#define PREDICCION_HORIZONTE_MAX_US 200000u
+
+/**
+ * @brief Salida emitida, guardada para compararla con la medida real posterior.
+ */
+typedef struct {
+    uint32_t t_objetivo_us;                 /**< Instante que representa la salida. */
+    float    valor[PREDICCION_MAX_DEDOS];   /**< Valor enviado a cada dedo. */
+} prediccion_salida_t;
+
+/**
+ * @brief Estado del predictor alfa-beta (posición y velocidad por dedo).
+ */
+typedef struct {
+    uint8_t  num_dedos;                     /**< Dedos en uso. */
+    float    alpha;                         /**< Ganancia de posición. */
+    float    beta;                          /**< Ganancia de velocidad. */
+    float    vmax;                          /**< Valor máximo de salida (la mínima es 0). */
+    bool     habilitada;                    /**< Si es false la salida es la última medida. */
+    bool     iniciado;                      /**< Ya se recibió al menos una medida. */
+    uint32_t t_ultima_us;                   /**< Instante de la última medida. */
+    float    x[PREDICCION_MAX_DEDOS];       /**< Posición estimada. */
+    float    v[PREDICCION_MAX_DEDOS];       /**< Velocidad estimada (unidades/s). */
+    float    medida[PREDICCION_MAX_DEDOS];  /**< Última medida recibida. */
+    uint32_t horizonte_us;                  /**< Último horizonte de proyección usado. */
+
+    prediccion_salida_t salidas[PREDICCION_HISTORIAL]; /**< Salidas pendientes de evaluar. */
+    uint32_t salidas_head;                  /**< Índice de escritura del historial. */
+    uint32_t salidas_tail;                  /**< Índice de la salida más antigua sin evaluar. */
+    float    error_acum;                    /**< Suma de |salida - medida real|. */
+    uint32_t error_muestras;                /**< Número de comparaciones acumuladas. */
+} prediccion_t;
+
+/**
+ * @brief Inicializa el predictor.
+ * @param p         Predictor a inicializar.
+ * @param num_dedos Número de dedos (máximo PREDICCION_MAX_DEDOS).
+ * @param alpha     Ganancia de posición (0–1).
+ * @param beta      Ganancia de velocidad (0–1).
+ * @param vmax      Valor máximo de salida; las salidas se recortan a [0, vmax].
+ */
+void prediccion_init(prediccion_t *p, uint8_t num_dedos, float alpha, float beta, float vmax);
+
+/**
+ * @brief Activa o desactiva la proyección y reinicia el error de seguimiento.
+ * @param p          Predictor.
+ * @param habilitada true para proyectar, false para entregar la última medida.
+ */
+void prediccion_habilitar(prediccion_t *p, bool habilitada);
+
+/**
+ * @brief Incorpora una medida de todos los dedos.
+ *
+ * Actualiza el filtro y compara con esta medida las salidas anteriores cuyo
+ * instante objetivo ya llegó, acumulando el error de seguimiento.
+ *
+ * @param p       Predictor.
+ * @param medidas Valor medido de cada dedo.
+ * @param t_us    Instante de muestreo de la medida.
+ */
+void prediccion_actualizar(prediccion_t *p, const float medidas[], uint32_t t_us);
+
+/**
+ * @brief Calcula la salida de cada dedo proyectada un horizonte hacia adelante.
+ *
+ * Si la predicción está deshabilitada entrega la última medida. La salida se
+ * recorta a [0, vmax] y se guarda para medir el error de seguimiento.
+ *
+ * @param p            Predictor.
+ * @param horizonte_us Latencia a compensar desde la última medida (µs).
+ * @param[out] out     Valor de cada dedo.
+ */
+void prediccion_salida(prediccion_t *p, uint32_t horizonte_us, float out[]);
+
+/**
+ * @brief Error medio absoluto de seguimiento desde el último reinicio.
+ * @param p Predictor.
+ * @return Error medio en unidades del guante (0 si aún no hay datos).
+ */
+float prediccion_error_medio(const prediccion_t *p);
+
+#endif /* PREDICCION_H */
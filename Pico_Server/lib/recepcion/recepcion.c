@@ -0,0 +1,368 @@
+/**
+ * @file recepcion.c
+ * @brief Implementación de la recepción de tramas y del buffer de reproducción.
+ */
+
+#include "recepcion.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert((COLA_ESTADOS & (COLA_ESTADOS - 1)) == 0, "COLA_ESTADOS debe ser potencia de 2");
+_Static_assert(COLA_ESTADOS >= PLAYOUT_RETARDO_MAX_US / PERIODO_MUESTREO_MIN_US + TRAMA_MAX_ESTADOS,
+               "COLA_ESTADOS no cubre PLAYOUT_RETARDO_MAX_US mas una trama completa");
+
+/**
+ * @brief Limita un valor entero al rango cerrado [a, b].
+ *
+ * @param x Valor de entrada.
+ * @param a Límite inferior.
+ * @param b Límite superior.
+ * @return Valor de x recortado al intervalo [a, b].
+ */
+static int clampi(int x, int a, int b) {
+    if (x < a) return a;
+    if (x > b) return b;
+    return x;
+}
+
+/**
+ * @brief Inicializa el receptor vacío y sin sincronizar.
+ * @param r Receptor.
+ */
+void recepcion_init(recepcion_t *r) {
+    memset(r, 0, sizeof(*r));
+    r->lote_estimado = UINT32_MAX;
+    r->playout.retardo_us = PLAYOUT_RETARDO_MIN_US;
+}
+
+/**
+ * @brief Parsea una trama recibida del guante.
+ *
+ * Acepta dos formatos:
+ * - Clásico: `H,d0,d1,d2,d3,d4`.
+ * - Secuenciado: `S,<seq>,<t_us>,<periodo_us>,<n>,<e0>,...,<e(n-1)>`, con los
+ *   estados del más antiguo al más reciente y 5 dígitos por estado.
+ *
+ * @param line Cadena terminada en '\0'.
+ * @param out Trama decodificada.
+ * @return true si la trama es válida y se llenó out, false en caso contrario.
+ */
+bool recepcion_parsear(const char *line, trama_t *out) {
+    if (line[0] == 'H') {
+        int v[5];
+        int read_count = sscanf(line, "H,%d,%d,%d,%d,%d",
+                                &v[0], &v[1], &v[2], &v[3], &v[4]);
+
+        if (read_count != 5) return false;
+
+        out->secuenciada = false;
+        out->n = 1;
+        for(int i=0; i<5; i++) out->estados[0][i] = (uint8_t)clampi(v[i], 0, RECEPCION_VMAX);
+        return true;
+    }
+
+    if (line[0] != 'S' || line[1] != ',') return false;
+
+    // Cabecera: seq, t_us, periodo_us, n
+    const char *p = line + 2;
+    uint32_t campos[4];
+    for (int i = 0; i < 4; i++) {
+        char *end;
+        campos[i] = (uint32_t)strtoul(p, &end, 10);
+        if (end == p || *end != ',') return false;
+        p = end + 1;
+    }
+
+    uint32_t n = campos[3];
+    if (n == 0 || n > TRAMA_MAX_ESTADOS) return false;
+
+    // Estados: 5 dígitos separados por ',' y sin nada al final
+    for (uint32_t k = 0; k < n; k++) {
+        for (int i = 0; i < RECEPCION_DEDOS; i++) {
+            if (p[i] < '0' || p[i] > '9') return false;
+            out->estados[k][i] = (uint8_t)(p[i] - '0');
+        }
+        p += RECEPCION_DEDOS;
+        char sep = (k + 1 < n) ? ',' : '\0';
+        if (*p != sep) return false;
+        p++;
+    }
+
+    out->secuenciada = true;
+    out->seq = campos[0];
+    out->t_us = campos[1];
+    out->periodo_us = campos[2];
+    out->n = (uint8_t)n;
+    return true;
+}
+
+/**
+ * @brief Encola un estado para que el consumidor lo aplique en su instante de reproducción.
+ *
+ * recepcion_extraer() solo mira la cabeza de la cola, así que t_play no puede
+ * retroceder: si el retardo baja o el offset de reloj se renueva, las muestras
+ * nuevas quedarían detrás de otras más tardías que ya esperan. Por eso un
+ * t_play anterior al último encolado se lleva a ese instante.
+ *
+ * @param r Receptor.
+ * @param estado Valores de los dedos en orden de trama.
+ * @param t_play Instante local en que debe aplicarse.
+ * @param t_muestra Instante local estimado en que se tomó la muestra.
+ * @param seq Secuencia de la muestra.
+ * @return true si se encoló, false si la cola estaba llena.
+ */
+static bool encolar_estado(recepcion_t *r, const uint8_t estado[RECEPCION_DEDOS], uint32_t t_play,
+                           uint32_t t_muestra, uint32_t seq) {
+    if (r->cola_head - r->cola_tail >= COLA_ESTADOS) {
+        r->stats.desbordes++;
+        return false;
+    }
+    if (r->cola_head != r->cola_tail && (int32_t)(t_play - r->ultimo_t_play) < 0) t_play = r->ultimo_t_play;
+    r->ultimo_t_play = t_play;
+
+    muestra_t *m = &r->cola[r->cola_head % COLA_ESTADOS];
+    memcpy(m->valores, estado, RECEPCION_DEDOS);
+    m->t_play = t_play;
+    m->t_muestra = t_muestra;
+    m->seq = seq;
+    r->cola_head++; // Publicar después de copiar
+    return true;
+}
+
+/**
+ * @brief Actualiza la estimación del offset entre el reloj del emisor y el local.
+ *
+ * Se toma el mínimo de (llegada - t_emisor) por ventana: el paquete que menos
+ * esperó en la red. Al cerrar cada ventana se adopta su mínimo, lo que sigue
+ * la deriva entre los cristales de ambas placas.
+ *
+ * @param pl Buffer de reproducción.
+ * @param llegada_us Instante local de llegada de la trama.
+ * @param t_emisor_us Marca de tiempo del emisor del estado más reciente.
+ */
+static void actualizar_offset(playout_t *pl, uint32_t llegada_us, uint32_t t_emisor_us) {
+    uint32_t transito = llegada_us - t_emisor_us;
+
+    if (!pl->offset_valido) {
+        pl->offset_reloj = pl->offset_ventana = transito;
+        pl->inicio_ventana = llegada_us;
+        pl->offset_valido = true;
+        return;
+    }
+    if ((int32_t)(transito - pl->offset_ventana) < 0) pl->offset_ventana = transito;
+    if ((int32_t)(transito - pl->offset_reloj) < 0) pl->offset_reloj = transito;
+
+    if (llegada_us - pl->inicio_ventana >= VENTANA_OFFSET_US) {
+        pl->offset_reloj = pl->offset_ventana;
+        pl->offset_ventana = transito;
+        pl->inicio_ventana = llegada_us;
+    }
+}
+
+/**
+ * @brief Adapta el retardo de reproducción al jitter observado.
+ *
+ * La espera de cada trama sobre el tránsito mínimo alimenta una media y una
+ * desviación exponenciales (factor 1/16, como el jitter de RTP). El objetivo
+ * cubre la antigüedad del estado más viejo de la trama más
+ * PLAYOUT_FACTOR_JITTER desviaciones, y el retardo vigente se acerca a él en
+ * pasos de 1/8 para no dar saltos en la mano.
+ *
+ * La trama lleva el lote actual y los K anteriores: cubrir solo un lote haría
+ * que los estados recuperados de la redundancia, un lote o más por detrás,
+ * llegaran casi siempre después de su instante y se descartaran.
+ *
+ * @param pl Buffer de reproducción.
+ * @param llegada_us Instante local de llegada de la trama.
+ * @param t_emisor_us Marca de tiempo del emisor del estado más reciente.
+ * @param span_trama_us Separación entre el primer y el último estado de la trama.
+ */
+static void actualizar_retardo(playout_t *pl, uint32_t llegada_us, uint32_t t_emisor_us,
+                               uint32_t span_trama_us) {
+    int32_t espera = (int32_t)(llegada_us - t_emisor_us - pl->offset_reloj);
+    if (espera < 0) espera = 0;
+
+    int32_t error = espera - pl->espera_media_us;
+    pl->espera_media_us += error / 16;
+    pl->espera_desv_us += ((error < 0 ? -error : error) - pl->espera_desv_us) / 16;
+
+    int32_t objetivo = (int32_t)span_trama_us + pl->espera_media_us
+                     + PLAYOUT_FACTOR_JITTER * pl->espera_desv_us;
+    pl->objetivo_us = clampi(objetivo, PLAYOUT_RETARDO_MIN_US, PLAYOUT_RETARDO_MAX_US);
+    pl->retardo_us += (pl->objetivo_us - pl->retardo_us) / 8;
+    pl->retardo_us = clampi(pl->retardo_us, PLAYOUT_RETARDO_MIN_US, PLAYOUT_RETARDO_MAX_US);
+}
+
+/**
+ * @brief Indica si una trama viene de un guante reiniciado.
+ *
+ * Un reinicio se reconoce porque el reloj del guante salta respecto al offset
+ * estimado (ver SALTO_RELOJ_US) o, sin offset todavía, porque la secuencia
+ * retrocede al menos SEQ_REINICIO. Con 500 muestras/s el solo retroceso de
+ * secuencia no basta: un guante que se reinicia poco después de arrancar
+ * vuelve a secuencias que la mano da por ya aplicadas.
+ *
+ * @param pl Buffer de reproducción.
+ * @param t Trama decodificada.
+ * @param llegada_us Instante local de llegada de la trama.
+ * @param delta_seq Avance de secuencia respecto a la última recibida.
+ * @return true si hay que resincronizar.
+ */
+static bool guante_reiniciado(const playout_t *pl, const trama_t *t, uint32_t llegada_us,
+                              int32_t delta_seq) {
+    if (!pl->offset_valido) return delta_seq <= -SEQ_REINICIO;
+    int32_t salto = (int32_t)(llegada_us - t->t_us - pl->offset_reloj);
+    return salto > SALTO_RELOJ_US || salto < -SALTO_RELOJ_US;
+}
+
+/**
+ * @brief Procesa una trama válida: contabiliza pérdidas y encola los estados nuevos.
+ *
+ * Para tramas secuenciadas, los estados con secuencia posterior a la última
+ * recibida se encolan en orden, cada uno con su instante de reproducción
+ * según la marca de tiempo del emisor. Los que pertenecen a datagramas
+ * perdidos se reconstruyen desde la redundancia si su antigüedad cabe en
+ * @ref VENTANA_INTERPOLACION_US; solo cuentan como recuperados si llegan a
+ * encolarse. Las muestras cuyo instante ya pasó se descartan, salvo la más
+ * reciente, que se aplica en cuanto sea posible. Todo estado que no llega a
+ * la cola (fuera de ventana, tardío o con la cola llena) cuenta como perdido.
+ *
+ * @param r Receptor.
+ * @param t Trama decodificada.
+ * @param llegada_us Instante local de llegada de la trama.
+ */
+void recepcion_procesar(recepcion_t *r, const trama_t *t, uint32_t llegada_us) {
+    playout_t *pl = &r->playout;
+
+    if (!t->secuenciada) {
+        encolar_estado(r, t->estados[0], llegada_us, llegada_us, 0);
+        return;
+    }
+
+    // Cuántos estados nuevos trae esta trama respecto a la última secuencia
+    uint32_t nuevos = 1;
+    if (r->seq_valida) {
+        int32_t delta = (int32_t)(t->seq - r->ultimo_seq);
+        if (guante_reiniciado(pl, t, llegada_us, delta)) {
+            // El guante se reinició: resincronizar secuencia, reloj y tamaño de lote
+            pl->offset_valido = false;
+            r->lote_estimado = UINT32_MAX;
+            r->stats.reinicios++;
+        } else if (delta <= 0) {
+            return; // Duplicada o desordenada: ya se aplicó algo más nuevo
+        } else {
+            nuevos = (uint32_t)delta;
+            if (nuevos < r->lote_estimado) r->lote_estimado = nuevos;
+        }
+    }
+    r->seq_valida = true;
+    r->ultimo_seq = t->seq;
+    r->stats.estados += nuevos;
+
+    // Las tramas más antiguas que la última no actualizan offset ni retardo
+    actualizar_offset(pl, llegada_us, t->t_us);
+    actualizar_retardo(pl, llegada_us, t->t_us, (uint32_t)(t->n - 1) * t->periodo_us);
+    uint32_t t_muestra_ultimo = t->t_us + pl->offset_reloj;
+    uint32_t t_play_ultimo = t_muestra_ultimo + (uint32_t)pl->retardo_us;
+
+    // Solo cuentan como estados del lote actual los que traiga la trama
+    uint32_t disponibles = (nuevos < t->n) ? nuevos : t->n;
+    r->stats.perdidos += nuevos - disponibles;
+
+    for (uint32_t k = t->n - disponibles; k < t->n; k++) {
+        uint32_t atras = (t->n - 1) - k; // 0 = estado más reciente
+        uint32_t antiguedad_us = atras * t->periodo_us;
+        bool recuperado = atras >= r->lote_estimado; // Estado de un datagrama perdido
+        if (recuperado && antiguedad_us > VENTANA_INTERPOLACION_US) {
+            r->stats.perdidos++;
+            continue;
+        }
+
+        uint32_t t_play = t_play_ultimo - antiguedad_us;
+        if (atras > 0 && (int32_t)(llegada_us - t_play) > 0) {
+            pl->descartes_tardios++;
+            r->stats.perdidos++; // Ya no se aplicará
+            continue;
+        }
+        if (!encolar_estado(r, t->estados[k], t_play, t_muestra_ultimo - antiguedad_us, t->seq - atras)) {
+            r->stats.perdidos++; // Cola llena
+            continue;
+        }
+        if (recuperado) r->stats.recuperados++;
+    }
+}
+
+/**
+ * @brief Saca de la cola la siguiente muestra si su instante ya llegó.
+ * @param r Receptor.
+ * @param ahora_us Instante local actual.
+ * @param[out] out Muestra extraída.
+ * @return true si se extrajo una muestra.
+ */
+bool recepcion_extraer(recepcion_t *r, uint32_t ahora_us, muestra_t *out) {
+    if (r->cola_tail == r->cola_head) return false;
+    const muestra_t *m = &r->cola[r->cola_tail % COLA_ESTADOS];
+    if ((int32_t)(ahora_us - m->t_play) < 0) return false;
+    *out = *m;
+    r->cola_tail++; // Liberar después de copiar
+    return true;
+}
+
+/**
+ * @brief Paso de la tarea de reproducción: aplica las muestras vencidas a través del predictor.
+ *
+ * Todas las muestras vencidas alimentan al predictor, pero solo la más
+ * reciente produce salida; las demás cuentan como saltadas. El horizonte es
+ * la antigüedad medida de esa muestra más la latencia fija no medible.
+ *
+ * @param r Receptor.
+ * @param p Predictor.
+ * @param ahora_us Instante local actual.
+ * @param[out] out Salida y próxima activación.
+ * @return true si hay salida para los servos.
+ */
+bool recepcion_reproducir(recepcion_t *r, prediccion_t *p, uint32_t ahora_us, reproduccion_t *out) {
+    bool hay_muestra = false;
+    muestra_t m;
+    while (recepcion_extraer(r, ahora_us, &m)) {
+        if (hay_muestra) r->stats.saltados++;
+        float medidas[RECEPCION_DEDOS];
+        for (int i = 0; i < RECEPCION_DEDOS; i++) medidas[i] = (float)m.valores[i];
+        prediccion_actualizar(p, medidas, m.t_muestra);
+        out->t_muestra = m.t_muestra;
+        out->seq = m.seq;
+        hay_muestra = true;
+    }
+    out->programada = recepcion_proxima(r, &out->t_proxima);
+    if (!hay_muestra) return false;
+
+    // Horizonte = antigüedad medida de la muestra + latencia fija no medible
+    out->antiguedad_us = ahora_us - out->t_muestra;
+    out->horizonte_us = out->antiguedad_us + PREDICCION_LATENCIA_FIJA_US;
+    if (out->horizonte_us > PREDICCION_HORIZONTE_MAX_US) out->horizonte_us = PREDICCION_HORIZONTE_MAX_US;
+    prediccion_salida(p, out->horizonte_us, out->valores);
+    return true;
+}
+
+/**
+ * @brief Instante de reproducción de la siguiente muestra de la cola.
+ * @param r Receptor.
+ * @param[out] t_play Instante local de la siguiente muestra.
+ * @return true si la cola no está vacía.
+ */
+bool recepcion_proxima(const recepcion_t *r, uint32_t *t_play) {
+    if (r->cola_tail == r->cola_head) return false;
+    *t_play = r->cola[r->cola_tail % COLA_ESTADOS].t_play;
+    return true;
+}
+
+/**
+ * @brief Muestras pendientes en la cola de reproducción.
+ * @param r Receptor.
+ * @return Profundidad de la cola.
+ */
+uint32_t recepcion_profundidad(const recepcion_t *r) {
+    return r->cola_head - r->cola_tail;
+}
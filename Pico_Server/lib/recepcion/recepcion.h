@@ -0,0 +1,232 @@
+/**
+ * @file recepcion.h
+ * @brief Recepción de tramas del guante y buffer de reproducción (playout) adaptativo.
+ *
+ * Decodifica las tramas `H` y `S`, contabiliza la pérdida efectiva, reconstruye
+ * los estados perdidos desde la redundancia y los encola con su instante de
+ * reproducción. recepcion_procesar() corre en el callback UDP (productor) y
+ * recepcion_reproducir() en la tarea de reproducción (consumidor).
+ *
+ * No depende del SDK: los instantes se pasan como argumentos, así que el
+ * módulo compila en el PC y Pico_Host/reproductor.c lo usa para reproducir
+ * sesiones grabadas o degradadas con tools/emulador_red.py.
+ */
+
+#ifndef RECEPCION_H
+#define RECEPCION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lib/prediccion/prediccion.h"
+
+/** Dedos por estado (5 dígitos por estado en la trama). */
+#define RECEPCION_DEDOS     5
+/** Valor máximo de un dedo en la trama clásica `H`. */
+#define RECEPCION_VMAX      9
+
+/** @brief Máximo de estados que puede transportar una trama secuenciada. */
+#define TRAMA_MAX_ESTADOS   64
+/**
+ * @brief Ventana de interpolación en µs.
+ *
+ * Un estado recuperado desde la redundancia solo se aplica si su antigüedad
+ * respecto al estado más reciente de la trama no supera esta ventana.
+ */
+#define VENTANA_INTERPOLACION_US 600000u
+/** @brief Periodo de muestreo más corto que se espera del guante (µs). */
+#define PERIODO_MUESTREO_MIN_US 2000
+/**
+ * @brief Capacidad de la cola de reproducción (potencia de 2).
+ *
+ * Con el retardo al máximo la cola guarda PLAYOUT_RETARDO_MAX_US de muestras
+ * pendientes y encima llega una trama completa (ver el _Static_assert).
+ */
+#define COLA_ESTADOS        256
+/**
+ * @brief Retardo mínimo de reproducción en µs.
+ *
+ * Cada muestra se aplica en `t_emisor + offset + retardo`, donde `offset` es
+ * el menor (llegada local - t_emisor) observado y `retardo` se adapta al
+ * jitter medido dentro de [PLAYOUT_RETARDO_MIN_US, PLAYOUT_RETARDO_MAX_US].
+ */
+#define PLAYOUT_RETARDO_MIN_US  0
+/**
+ * @brief Retardo máximo de reproducción en µs.
+ *
+ * Con 0 se obtiene el modo de mínima latencia: cada muestra se aplica en cuanto
+ * llega y solo la más reciente de cada lote llega a los servos.
+ */
+#define PLAYOUT_RETARDO_MAX_US  150000
+/** @brief Desviaciones de jitter que cubre el retardo objetivo. */
+#define PLAYOUT_FACTOR_JITTER   4
+/** @brief Duración de la ventana usada para estimar el offset de reloj (µs). */
+#define VENTANA_OFFSET_US   2000000u
+/** @brief Retroceso de secuencia a partir del cual se asume que el guante se reinició. */
+#define SEQ_REINICIO        1000
+/**
+ * @brief Salto del reloj del guante que delata un reinicio (µs).
+ *
+ * Con el offset estimado, (llegada - t_emisor - offset) es la espera en red de
+ * la trama. Tras un reinicio el reloj del guante vuelve a cero y esa espera
+ * aparente crece en todo el uptime anterior (nunca menos que lo que tarda el
+ * guante en arrancar y conectarse), tenga la secuencia el valor que tenga.
+ */
+#define SALTO_RELOJ_US      1000000
+
+/**
+ * @brief Trama decodificada (clásica `H` o secuenciada `S`).
+ */
+typedef struct {
+    bool     secuenciada;   /**< true si la trama trae secuencia y redundancia. */
+    uint32_t seq;           /**< Secuencia del estado más reciente. */
+    uint32_t t_us;          /**< Marca de tiempo del emisor para el estado más reciente. */
+    uint32_t periodo_us;    /**< Separación entre estados consecutivos en el emisor. */
+    uint8_t  n;             /**< Número de estados en la trama. */
+    uint8_t  estados[TRAMA_MAX_ESTADOS][RECEPCION_DEDOS]; /**< Estados, del más antiguo al más reciente. */
+} trama_t;
+
+/**
+ * @brief Muestra en la cola de reproducción.
+ */
+typedef struct {
+    uint32_t t_play;                    /**< Instante local en que debe aplicarse. */
+    uint32_t t_muestra;                 /**< Instante local estimado en que el guante tomó la muestra. */
+    uint32_t seq;                       /**< Secuencia de la muestra (0 en tramas `H`). */
+    uint8_t  valores[RECEPCION_DEDOS];  /**< Valores de los dedos en orden de trama. */
+} muestra_t;
+
+/**
+ * @brief Estadísticas de recepción para medir la pérdida efectiva.
+ */
+typedef struct {
+    uint32_t tramas;        /**< Tramas válidas recibidas. */
+    uint32_t bytes;         /**< Bytes de carga útil recibidos en tramas válidas. */
+    uint32_t invalidas;     /**< Tramas que no se pudieron parsear. */
+    uint32_t estados;       /**< Estados esperados según el avance de la secuencia. */
+    uint32_t recuperados;   /**< Estados perdidos reconstruidos desde la redundancia. */
+    uint32_t perdidos;      /**< Estados que nunca llegan a la cola: sin redundancia, tardíos o por cola llena (pérdida efectiva). */
+    uint32_t desbordes;     /**< Estados descartados por cola llena (también cuentan en perdidos). */
+    uint32_t saltados;      /**< Muestras vencidas reemplazadas por otra más nueva sin aplicarse. */
+    uint32_t reinicios;     /**< Reinicios del guante detectados (resincronizaciones). */
+} rx_stats_t;
+
+/**
+ * @brief Estado del buffer de reproducción (playout) adaptativo.
+ */
+typedef struct {
+    uint32_t offset_reloj;      /**< Menor (llegada local - t_emisor) de la ventana anterior. */
+    uint32_t offset_ventana;    /**< Menor offset observado en la ventana en curso. */
+    uint32_t inicio_ventana;    /**< Instante local en que empezó la ventana de offset. */
+    bool     offset_valido;     /**< Indica si offset_reloj ya tiene un valor válido. */
+    int32_t  espera_media_us;   /**< Media de la espera en red sobre el mínimo (jitter). */
+    int32_t  espera_desv_us;    /**< Desviación media de esa espera. */
+    int32_t  objetivo_us;       /**< Retardo objetivo calculado a partir del jitter. */
+    int32_t  retardo_us;        /**< Retardo vigente (converge suavemente al objetivo). */
+    uint32_t descartes_tardios; /**< Muestras descartadas por llegar después de su instante (también cuentan en perdidos). */
+} playout_t;
+
+/**
+ * @brief Resultado de un paso de reproducción (ver recepcion_reproducir).
+ */
+typedef struct {
+    uint32_t seq;                       /**< Secuencia de la muestra más reciente aplicada. */
+    uint32_t t_muestra;                 /**< Instante local estimado en que el guante la tomó. */
+    uint32_t antiguedad_us;             /**< Antigüedad de esa muestra al aplicarse (latencia medida). */
+    uint32_t horizonte_us;              /**< Horizonte con que se proyectó la salida. */
+    float    valores[RECEPCION_DEDOS];  /**< Salida del predictor para los servos. */
+    bool     programada;                /**< Quedan muestras en la cola. */
+    uint32_t t_proxima;                 /**< Instante de la siguiente muestra, si programada. */
+} reproduccion_t;
+
+/**
+ * @brief Receptor: cola de reproducción, secuencia, playout y estadísticas.
+ *
+ * El callback UDP escribe todo salvo cola_tail y stats.saltados, que son del main.
+ */
+typedef struct {
+    muestra_t cola[COLA_ESTADOS];   /**< Cola circular con t_play no decreciente (ver recepcion_procesar). */
+    volatile uint32_t cola_head;    /**< Índice de escritura (solo recepcion_procesar). */
+    volatile uint32_t cola_tail;    /**< Índice de lectura (solo recepcion_extraer). */
+    uint32_t ultimo_t_play;         /**< t_play de la última muestra encolada. */
+    rx_stats_t stats;               /**< Estadísticas de recepción. */
+    playout_t playout;              /**< Buffer de reproducción. */
+    uint32_t ultimo_seq;            /**< Secuencia del último estado recibido. */
+    bool     seq_valida;            /**< Ya se recibió al menos una trama secuenciada. */
+    uint32_t lote_estimado;         /**< Menor avance de secuencia entre tramas: muestras por lote. */
+} recepcion_t;
+
+/**
+ * @brief Inicializa el receptor vacío y sin sincronizar.
+ * @param r Receptor.
+ */
+void recepcion_init(recepcion_t *r);
+
+/**
+ * @brief Parsea una trama recibida del guante.
+ *
+ * Acepta dos formatos:
+ * - Clásico: `H,d0,d1,d2,d3,d4`.
+ * - Secuenciado: `S,<seq>,<t_us>,<periodo_us>,<n>,<e0>,...,<e(n-1)>`, con los
+ *   estados del más antiguo al más reciente y 5 dígitos por estado.
+ *
+ * @param line Cadena terminada en '\0'.
+ * @param out Trama decodificada.
+ * @return true si la trama es válida y se llenó out, false en caso contrario.
+ */
+bool recepcion_parsear(const char *line, trama_t *out);
+
+/**
+ * @brief Procesa una trama válida: contabiliza pérdidas y encola los estados nuevos.
+ *
+ * Los t_play se encolan sin retroceder: si el retardo baja o se renueva el
+ * offset de reloj, una muestra nueva no se aplica antes que otra ya encolada.
+ *
+ * @param r Receptor.
+ * @param t Trama decodificada.
+ * @param llegada_us Instante local de llegada de la trama.
+ */
+void recepcion_procesar(recepcion_t *r, const trama_t *t, uint32_t llegada_us);
+
+/**
+ * @brief Saca de la cola la siguiente muestra si su instante ya llegó.
+ * @param r Receptor.
+ * @param ahora_us Instante local actual.
+ * @param[out] out Muestra extraída.
+ * @return true si se extrajo una muestra.
+ */
+bool recepcion_extraer(recepcion_t *r, uint32_t ahora_us, muestra_t *out);
+
+/**
+ * @brief Paso de la tarea de reproducción: aplica las muestras vencidas a través del predictor.
+ *
+ * Todas las muestras vencidas alimentan al predictor y las que se reemplazan
+ * sin aplicarse cuentan en stats.saltados. La salida se proyecta la
+ * antigüedad de la más reciente más PREDICCION_LATENCIA_FIJA_US, hasta
+ * PREDICCION_HORIZONTE_MAX_US. Lo usan el firmware y Pico_Host/reproductor.
+ *
+ * @param r Receptor.
+ * @param p Predictor (RECEPCION_DEDOS dedos).
+ * @param ahora_us Instante local actual.
+ * @param[out] out Salida y próxima activación; programada y t_proxima se
+ *                 rellenan siempre, el resto solo si retorna true.
+ * @return true si venció al menos una muestra y hay salida para los servos.
+ */
+bool recepcion_reproducir(recepcion_t *r, prediccion_t *p, uint32_t ahora_us, reproduccion_t *out);
+
+/**
+ * @brief Instante de reproducción de la siguiente muestra de la cola.
+ * @param r Receptor.
+ * @param[out] t_play Instante local de la siguiente muestra.
+ * @return true si la cola no está vacía.
+ */
+bool recepcion_proxima(const recepcion_t *r, uint32_t *t_play);
+
+/**
+ * @brief Muestras pendientes en la cola de reproducción.
+ * @param r Receptor.
+ * @return Profundidad de la cola.
+ */
+uint32_t recepcion_profundidad(const recepcion_t *r);
+
+#endif /* RECEPCION_H */
@@ -6,6 +6,7 @@
 #include "servo.h"
 #include "pico/stdlib.h"
 #include <math.h>
+#include <string.h>
 
 /* --- Registros PCA9685 --- */
 /** Registro MODE1 del PCA9685. */
@@ -100,6 +101,10 @@ static bool set_freq(servo_pca_t *dev, float freq_hz) {
 
 /**
  * @brief Escribe valores RAW de PWM en un canal.
+ *
+ * Reintenta hasta SERVO_I2C_REINTENTOS veces y cuenta reintentos y fallos
+ * en el descriptor para la telemetría.
+ *
  * @param dev     Dispositivo PCA9685.
  * @param channel Canal [0..15].
  * @param on      Cuenta de inicio (0–4095).
@@ -107,7 +112,7 @@ static bool set_freq(servo_pca_t *dev, float freq_hz) {
  * @return true si la escritura I2C fue correcta, false en error.
  */
 static bool set_pwm_raw(servo_pca_t *dev, uint8_t channel, uint16_t on, uint16_t off) {
-    if (channel > 15) return false;
+    if (channel >= SERVO_NUM_CANALES) return false;
     
     // I2C Write de 5 bytes: ~100us a 400kHz. 
     // Completamente seguro para llamar dentro de un ciclo de Polling rápido.
@@ -120,7 +125,15 @@ static bool set_pwm_raw(servo_pca_t *dev, uint8_t channel, uint16_t on, uint16_t
         (uint8_t)(off >> 8)
     };
 
-    return i2c_write_blocking(dev->i2c, dev->addr, buf, 5, false) == 5;
+    for (int intento = 0; intento <= SERVO_I2C_REINTENTOS; intento++) {
+        if (intento > 0) dev->reintentos_i2c++;
+        if (i2c_write_blocking(dev->i2c, dev->addr, buf, 5, false) == 5) {
+            dev->off[channel] = off;
+            return true;
+        }
+    }
+    dev->errores_i2c++;
+    return false;
 }
 
 /**
@@ -141,6 +154,9 @@ bool servo_init(servo_pca_t *dev) {
     dev->i2c = SERVO_I2C;
     dev->addr = PCA9685_ADDR;
     dev->freq_hz = 0.0f;
+    dev->errores_i2c = 0;
+    dev->reintentos_i2c = 0;
+    memset(dev->off, 0, sizeof(dev->off));
 
     // Reset software básico
     write_byte(dev->i2c, dev->addr, MODE1, 0x00);
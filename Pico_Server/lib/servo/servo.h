@@ -21,6 +21,10 @@
 #define PCA9685_ADDR      0x40
 /** Frecuencia PWM para servos (Hz). */
 #define SERVO_FREQ_HZ     50.0f
+/** Reintentos de una escritura de canal fallida antes de darla por perdida. */
+#define SERVO_I2C_REINTENTOS 1
+/** Canales PWM del PCA9685. */
+#define SERVO_NUM_CANALES 16
 
 /* --- RANGOS DE TRABAJO --- */
 /** Pulso mínimo del servo (µs). */
@@ -37,6 +41,9 @@ typedef struct {
     i2c_inst_t *i2c;  /**< Instancia I2C asociada. */
     uint8_t addr;     /**< Dirección I2C del PCA9685. */
     float freq_hz;    /**< Frecuencia PWM configurada. */
+    uint32_t errores_i2c;    /**< Escrituras de canal fallidas tras agotar los reintentos. */
+    uint32_t reintentos_i2c; /**< Reintentos de escritura realizados. */
+    uint16_t off[SERVO_NUM_CANALES]; /**< Último valor escrito en el registro LEDn_OFF de cada canal. */
 } servo_pca_t;
 
 /**
@@ -0,0 +1,24 @@
+/**
+ * @file telemetria.c
+ * @brief Utilidades del snapshot de telemetría.
+ */
+
+#include "telemetria.h"
+
+/**
+ * @brief Suma una latencia al histograma log2.
+ *
+ * Cubeta 0 para menos de 1024 µs; la cubeta i > 0 cubre [2^(i+9), 2^(i+10)) µs
+ * y la última acumula todo lo que la supera. Cuesta un clz y un incremento.
+ *
+ * @param hist       Histograma de TELEMETRIA_HIST_BINS cubetas.
+ * @param latencia_us Latencia en µs.
+ */
+void telemetria_hist_agregar(uint32_t hist[TELEMETRIA_HIST_BINS], uint32_t latencia_us) {
+    uint32_t cubeta = 0;
+    if (latencia_us >= 1024u) {
+        cubeta = (32u - (uint32_t)__builtin_clz(latencia_us)) - 10u;
+        if (cubeta >= TELEMETRIA_HIST_BINS) cubeta = TELEMETRIA_HIST_BINS - 1;
+    }
+    hist[cubeta]++;
+}
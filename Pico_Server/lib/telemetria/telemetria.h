@@ -0,0 +1,143 @@
+/**
+ * @file telemetria.h
+ * @brief Formato binario del snapshot de telemetría de la mano.
+ *
+ * La mano responde a `T?` en TELEMETRIA_PORT con un telemetria_snapshot_t.
+ * Además, quien envíe `R?` a ese puerto recibe durante
+ * TELEMETRIA_TRAZA_TIMEOUT_MS la traza de servos: lotes telemetria_traza_lote_t
+ * con cada actualización aplicada a los servos.
+ *
+ * Todos los campos son little-endian y las estructuras están empaquetadas;
+ * `tools/telemetria.py` y `tools/emulador_red.py` replican este formato, así
+ * que cualquier cambio debe subir TELEMETRIA_VERSION.
+ */
+
+#ifndef TELEMETRIA_H
+#define TELEMETRIA_H
+
+#include <stdint.h>
+
+/** Puerto UDP de telemetría (el de control es 4242). */
+#define TELEMETRIA_PORT     4243
+/** Marca del snapshot ("TLM1" en memoria). */
+#define TELEMETRIA_MAGIA    0x314D4C54u
+/** Versión del formato (2: se añade la traza de servos `R?`). */
+#define TELEMETRIA_VERSION  2
+/** Cubetas del histograma de latencia (log2). */
+#define TELEMETRIA_HIST_BINS 12
+/** Tareas del planificador incluidas en el snapshot. */
+#define TELEMETRIA_MAX_TAREAS 8
+/** Largo del nombre de tarea (sin terminador si lo ocupa entero). */
+#define TELEMETRIA_NOMBRE_LEN 8
+
+/** Marca de un lote de traza de servos ("TRZ1" en memoria). */
+#define TELEMETRIA_TRAZA_MAGIA      0x315A5254u
+/** Registros por lote de traza. */
+#define TELEMETRIA_TRAZA_LOTE       16
+/** Dedos por registro de traza. */
+#define TELEMETRIA_TRAZA_DEDOS      5
+/** Tiempo sin renovar `R?` tras el que la mano deja de enviar la traza (ms). */
+#define TELEMETRIA_TRAZA_TIMEOUT_MS 3000
+
+/**
+ * @brief Uso de un pool de memoria de lwIP.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t usado;       /**< Elementos o bytes en uso. */
+    uint16_t maximo;      /**< Máximo en uso observado. */
+    uint16_t disponible;  /**< Capacidad total. */
+    uint16_t errores;     /**< Reservas fallidas. */
+} telemetria_pool_t;
+
+/**
+ * @brief Tiempos de una tarea del planificador en la ventana actual.
+ */
+typedef struct __attribute__((packed)) {
+    char     nombre[TELEMETRIA_NOMBRE_LEN]; /**< Nombre truncado. */
+    uint32_t ejecuciones;                   /**< Ejecuciones. */
+    uint32_t exec_max_us;                   /**< Mayor tiempo de ejecución. */
+    uint32_t retraso_max_us;                /**< Mayor retraso de inicio. */
+    uint32_t plazos_perdidos;               /**< Plazos incumplidos. */
+} telemetria_tarea_t;
+
+/**
+ * @brief Snapshot completo enviado en respuesta a `T?`.
+ *
+ * Los contadores de recepción, servos y Wi-Fi son acumulados desde el
+ * arranque (la CLI calcula tasas por diferencia). El histograma y la
+ * latencia máxima son los de la última ventana de estadísticas cerrada;
+ * las tareas, los de la ventana en curso.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magia;              /**< TELEMETRIA_MAGIA. */
+    uint16_t version;            /**< TELEMETRIA_VERSION. */
+    uint16_t tamano;             /**< sizeof(telemetria_snapshot_t). */
+    uint32_t uptime_ms;          /**< Tiempo desde el arranque. */
+    uint32_t consultas;          /**< Snapshots servidos (incluido este). */
+
+    uint32_t tramas;             /**< Tramas válidas recibidas. */
+    uint32_t bytes;              /**< Bytes de tramas válidas. */
+    uint32_t invalidas;          /**< Tramas con error de parseo. */
+    uint32_t estados;            /**< Estados nuevos esperados. */
+    uint32_t recuperados;        /**< Estados recuperados por redundancia. */
+    uint32_t perdidos;           /**< Estados perdidos. */
+    uint32_t desbordes;          /**< Estados descartados por cola llena. */
+    uint32_t saltados;           /**< Estados reproducidos sin llegar a los servos. */
+    uint32_t descartes_tardios;  /**< Estados que llegaron tarde al playout. */
+    uint32_t aplicadas;          /**< Actualizaciones de servos. */
+
+    uint32_t i2c_errores;        /**< Escrituras I2C fallidas. */
+    uint32_t i2c_reintentos;     /**< Reintentos I2C. */
+
+    uint32_t latencia_hist[TELEMETRIA_HIST_BINS]; /**< Cubeta 0: <1 ms; i>0: [2^(i+9), 2^(i+10)) µs; la última abierta. */
+    uint32_t latencia_max_us;    /**< Mayor latencia de la ventana. */
+    int32_t  playout_retardo_us; /**< Retardo de reproducción vigente. */
+    int32_t  playout_jitter_us;  /**< Desviación de la espera en red. */
+
+    uint16_t reposo_permil;      /**< Fracción del bucle en reposo (‰). */
+    uint8_t  num_tareas;         /**< Entradas válidas en tareas[]. */
+    uint8_t  reservado;          /**< Relleno (0). */
+    telemetria_tarea_t tareas[TELEMETRIA_MAX_TAREAS]; /**< Tiempos por tarea. */
+
+    telemetria_pool_t heap;      /**< Heap de lwIP (bytes). */
+    telemetria_pool_t pbuf_pool; /**< Pool de pbufs de RX. */
+    telemetria_pool_t pbuf_ref;  /**< Pool de pbufs por referencia (TX). */
+    telemetria_pool_t udp_pcb;   /**< Pool de PCB UDP. */
+
+    uint32_t wifi_caidas;        /**< Caídas del enlace. */
+    uint32_t wifi_reconexion_ms; /**< Duración del último corte. */
+} telemetria_snapshot_t;
+
+/**
+ * @brief Una actualización de los servos.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t t_us;                              /**< Instante local (time_us_32) tras escribir los registros. */
+    uint32_t seq;                               /**< Secuencia de la muestra más reciente aplicada. */
+    int16_t  valor_c[TELEMETRIA_TRAZA_DEDOS];   /**< Valor enviado a cada dedo (0–9) en centésimas, en orden de trama. */
+    uint16_t pwm_off[TELEMETRIA_TRAZA_DEDOS];   /**< Registro LEDn_OFF escrito en el PCA9685 para cada dedo. */
+} telemetria_traza_t;
+
+/**
+ * @brief Lote de traza enviado al suscriptor de `R?`.
+ *
+ * Se envían solo los `n` registros válidos. t_envio_us permite al host
+ * estimar el offset entre su reloj y el de la mano.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magia;        /**< TELEMETRIA_TRAZA_MAGIA. */
+    uint16_t version;      /**< TELEMETRIA_VERSION. */
+    uint16_t n;            /**< Registros válidos. */
+    uint32_t t_envio_us;   /**< Instante local del envío. */
+    uint32_t descartados;  /**< Registros perdidos por lote lleno desde la suscripción. */
+    telemetria_traza_t registros[TELEMETRIA_TRAZA_LOTE]; /**< Registros, del más antiguo al más reciente. */
+} telemetria_traza_lote_t;
+
+/**
+ * @brief Suma una latencia al histograma log2.
+ * @param hist       Histograma de TELEMETRIA_HIST_BINS cubetas.
+ * @param latencia_us Latencia en µs.
+ */
+void telemetria_hist_agregar(uint32_t hist[TELEMETRIA_HIST_BINS], uint32_t latencia_us);
+
+#endif /* TELEMETRIA_H */
@@ -20,8 +20,8 @@
 #define LWIP_SOCKET                 0
 /** @brief Deshabilita la API Netconn de lwIP. */
 #define LWIP_NETCONN                0
-/** @brief Deshabilita soporte IGMP (no se usan grupos multicast). */
-#define LWIP_IGMP                   0
+/** @brief Habilita IGMP para unirse al grupo multicast del guante. */
+#define LWIP_IGMP                   1
 /** @brief Habilita ICMP (por ejemplo, respuestas a ping). */
 #define LWIP_ICMP                   1
 
@@ -63,6 +63,26 @@
 /** @brief Habilita el cliente DHCP para obtener IP automáticamente. */
 #define LWIP_DHCP                   1  // Importante para obtener IP del router
 
+// --- Estadísticas (telemetría e informe de memoria) ---
+/** @brief Habilita los contadores internos de lwIP. */
+#define LWIP_STATS                  1
+/** @brief No incluye las funciones de volcado de estadísticas por consola. */
+#define LWIP_STATS_DISPLAY          0
+/** @brief Uso, pico y errores del heap de lwIP. */
+#define MEM_STATS                   1
+/** @brief Uso, pico y errores de cada pool (pbufs, PCB, ...). */
+#define MEMP_STATS                  1
+/** @brief Contadores por protocolo no usados (ahorran RAM). */
+#define LINK_STATS                  0
+#define ETHARP_STATS                0
+#define IP_STATS                    0
+#define IPFRAG_STATS                0
+#define ICMP_STATS                  0
+#define IGMP_STATS                  0
+#define UDP_STATS                   0
+#define TCP_STATS                   0
+#define SYS_STATS                   0
+
 // --- Integración con la Pico ---
 /**
  * @brief Generador de números aleatorios para lwIP.
@@ -0,0 +1,585 @@
+#!/usr/bin/env python3
+"""
+emulador_red.py - Proxy UDP con red degradada entre un guante simulado o reproducido y la mano.
+
+Envía a la mano (puerto 4242) las tramas `S` de un guante simulado, de una
+sesión grabada del guante o de otro proceso que las mande al puerto local
+--escucha. Cada datagrama pasa antes por una red emulada con pérdida
+(Bernoulli o ráfagas Gilbert-Elliott), retardo gaussiano, atascos, reorden,
+duplicados y límite de ancho de banda. Todo el azar sale de --semilla, así que
+una misma fuente y una misma semilla repiten exactamente las mismas decisiones.
+
+A la vez se suscribe con `R?` a la traza de servos de la mano (puerto 4243, ver
+Pico_Server/lib/telemetria/telemetria.h). Con ella calcula, por cada
+actualización de los servos, la latencia extremo a extremo desde que se tomó
+la muestra y el error de seguimiento respecto a lo que envió el guante.
+
+Con --volcar no hace falta la mano: la prueba corre en tiempo virtual y cada
+trama se escribe al entrar en la red (`E <t_us> <trama>`) y al salir de ella
+(`R <t_us> <trama>`), para reproducirla con Pico_Host/reproductor.
+
+Uso:
+    python3 tools/emulador_red.py <ip_mano> --duracion 30 --semilla 1 \\
+        --perdida 0.05 --retardo-ms 20 --jitter-ms 8 --csv informe.csv
+    python3 tools/emulador_red.py --volcar sesion.txt --perdida 0.1 --redundancia 2
+"""
+
+import argparse
+import bisect
+import heapq
+import math
+import os
+import random
+import re
+import select
+import socket
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import telemetria  # noqa: E402  (formato del snapshot `T?`)
+
+PUERTO_MANO = 4242
+MASCARA = 0xFFFFFFFF
+DEDOS = 5
+
+# Lote de traza (telemetria_traza_lote_t), little-endian y empaquetado
+TRAZA_MAGIA = 0x315A5254
+TRAZA_CABECERA = struct.Struct("<IHHII")
+TRAZA_REGISTRO = struct.Struct("<II%dh%dH" % (DEDOS, DEDOS))
+
+# Renovación de la suscripción `R?` (la mano la da por vencida a los 3 s)
+RENOVAR_TRAZA_S = 1.0
+# Ventana del mínimo (llegada - envío) con que se estima el offset de relojes
+VENTANA_OFFSET_US = 5000000
+# Cabeceras IP + UDP que cuentan para el ancho de banda
+CABECERAS_BYTES = 28
+
+TRAMA_S = re.compile(r"S,\d+,\d+,\d+,\d+(?:,\d{%d})+" % DEDOS)
+
+
+def ahora_us():
+    """Reloj monotónico del host en µs."""
+    return time.monotonic_ns() // 1000
+
+
+# --- FUENTES DE TRAMAS ---
+class GuanteSimulado:
+    """Guante sintético con el mismo formato, lote y redundancia que Pico_Client.c."""
+
+    def __init__(self, rng, periodo_us, muestras_por_trama, redundancia_k):
+        self.periodo_us = periodo_us
+        self.muestras_por_trama = muestras_por_trama
+        self.historial_len = (redundancia_k + 1) * muestras_por_trama
+        self.historial = {}
+        self.seq = 0
+        self.en_lote = 0
+        # Cada dedo abre y cierra a su ritmo (0,3–1,5 Hz), con fase al azar
+        self.frec = [rng.uniform(0.3, 1.5) for _ in range(DEDOS)]
+        self.fase = [rng.uniform(0.0, 2.0 * math.pi) for _ in range(DEDOS)]
+
+    def muestrear(self, t_us):
+        """Toma una muestra en t_us; devuelve la trama si completa un lote, si no None."""
+        t = t_us / 1e6
+        estado = tuple(int(round(4.5 + 4.5 * math.sin(2.0 * math.pi * f * t + fi)))
+                       for f, fi in zip(self.frec, self.fase))
+        self.seq += 1
+        self.historial[self.seq] = estado
+        self.historial.pop(self.seq - self.historial_len, None)
+
+        self.en_lote += 1
+        if self.en_lote < self.muestras_por_trama:
+            return None
+        self.en_lote = 0
+        n = min(self.seq, self.historial_len)
+        partes = ["S", str(self.seq), str(t_us & MASCARA), str(self.periodo_us), str(n)]
+        for s in range(self.seq - n + 1, self.seq + 1):
+            partes.append("".join(str(v) for v in self.historial[s]))
+        return ",".join(partes).encode()
+
+
+def leer_sesion(ruta):
+    """Tramas `S` de un log de consola del guante, con su instante relativo (µs)."""
+    tramas = []
+    t0 = None
+    with open(ruta, errors="replace") as f:
+        for linea in f:
+            m = TRAMA_S.search(linea)
+            if not m:
+                continue
+            texto = m.group(0)
+            t_us = int(texto.split(",")[2])
+            if t0 is None:
+                t0 = t_us
+            rel = (t_us - t0) & MASCARA
+            if tramas and rel < tramas[-1][0]:
+                break  # El guante se reinició: la sesión acaba aquí
+            tramas.append((rel, texto.encode()))
+    return tramas
+
+
+def parsear_trama(datos):
+    """(seq, periodo_us, estados) de una trama `S`, o None."""
+    try:
+        campos = datos.decode().split(",")
+        if campos[0] != "S":
+            return None
+        seq, _, periodo, n = (int(c) for c in campos[1:5])
+        estados = [tuple(int(d) for d in e) for e in campos[5:5 + n]]
+        return seq, periodo, estados
+    except (UnicodeDecodeError, ValueError, IndexError):
+        return None
+
+
+# --- RED EMULADA ---
+class Red:
+    """Decide el destino de cada datagrama. Cada efecto tiene su propio generador."""
+
+    def __init__(self, args, semilla):
+        def rng(nombre):
+            return random.Random("%s-%s" % (semilla, nombre))
+        self.args = args
+        self.rng_perdida = rng("perdida")
+        self.rng_ge = rng("gilbert")
+        self.rng_retardo = rng("retardo")
+        self.rng_atasco = rng("atasco")
+        self.rng_reorden = rng("reorden")
+        self.rng_duplicado = rng("duplicado")
+        self.ge_malo = False
+        self.enlace_libre_us = 0
+        self.ultima_salida_us = 0
+        self.atasco_hasta_us = 0
+        self.c = dict(entrantes=0, cola=0, perdidos=0, reordenados=0, duplicados=0,
+                      atascados=0, entregados=0, retardo_total_us=0, retardo_max_us=0)
+
+    def procesar(self, t_us, datos):
+        """Lista de instantes de salida del datagrama (vacía si se pierde)."""
+        a = self.args
+        c = self.c
+        c["entrantes"] += 1
+
+        # 1. Ancho de banda: cola FIFO a la salida con límite de espera
+        t = t_us
+        if a.ancho_kbps > 0:
+            bits = (len(datos) + CABECERAS_BYTES) * 8
+            inicio = max(t_us, self.enlace_libre_us)
+            fin = inicio + bits * 1000 // a.ancho_kbps
+            if fin - t_us > a.cola_max_ms * 1000:
+                c["cola"] += 1
+                return []
+            self.enlace_libre_us = fin
+            t = fin
+
+        # 2. Pérdida independiente y en ráfagas (Gilbert-Elliott: en estado malo se pierde todo)
+        perdido = self.rng_perdida.random() < a.perdida
+        if a.rafaga:
+            p_entrar, p_salir = a.rafaga
+            if self.ge_malo:
+                self.ge_malo = self.rng_ge.random() >= p_salir
+            else:
+                self.ge_malo = self.rng_ge.random() < p_entrar
+            perdido = perdido or self.ge_malo
+        if perdido:
+            c["perdidos"] += 1
+            return []
+
+        # 3. Retardo gaussiano (truncado en 0) y atascos: nada sale hasta que terminan
+        retardo = max(0.0, self.rng_retardo.gauss(a.retardo_ms, a.jitter_ms)) * 1000
+        if t >= self.atasco_hasta_us and a.atasco and self.rng_atasco.random() < a.atasco[0]:
+            self.atasco_hasta_us = t + int(a.atasco[1] * 1000)
+        salida = t + int(retardo)
+        if t < self.atasco_hasta_us:
+            c["atascados"] += 1
+            salida = max(salida, self.atasco_hasta_us)
+
+        # 4. Orden: FIFO salvo los que se retrasan a propósito para que otros los adelanten
+        if self.rng_reorden.random() < a.reorden:
+            c["reordenados"] += 1
+            salida += int(a.reorden_ms * 1000)
+        else:
+            salida = max(salida, self.ultima_salida_us)
+            self.ultima_salida_us = salida
+
+        salidas = [salida]
+        if self.rng_duplicado.random() < a.duplicado:
+            c["duplicados"] += 1
+            salidas.append(salida + int(a.duplicado_ms * 1000))
+
+        c["entregados"] += 1
+        c["retardo_total_us"] += salida - t_us
+        c["retardo_max_us"] = max(c["retardo_max_us"], salida - t_us)
+        return salidas
+
+
+# --- MEDIDA ---
+class Medida:
+    """Verdad del guante, traza de la mano y cálculo de latencia y error."""
+
+    def __init__(self):
+        self.verdad = {}        # seq -> (t_host_us, estado)
+        self.lotes = []         # (t_rx_host_us, t_envio_mano_us, registros)
+        self.descartados = 0
+
+    def registrar_trama(self, t_us, datos):
+        """Guarda los estados de una trama que entra al proxy (t_us = muestra más reciente)."""
+        trama = parsear_trama(datos)
+        if not trama:
+            return
+        seq, periodo, estados = trama
+        n = len(estados)
+        for i, estado in enumerate(estados):
+            s = seq - (n - 1 - i)
+            if s not in self.verdad:
+                self.verdad[s] = (t_us - (n - 1 - i) * periodo, estado)
+
+    def registrar_lote(self, t_rx_us, datos):
+        """Decodifica un lote de traza; devuelve False si no lo es y lanza ValueError si es de otra versión."""
+        if len(datos) < TRAZA_CABECERA.size:
+            return False
+        magia, version, n, t_envio, descartados = TRAZA_CABECERA.unpack_from(datos, 0)
+        if magia != TRAZA_MAGIA:
+            return False
+        if version != telemetria.VERSION:
+            raise ValueError("traza v%d no soportada (se espera v%d)" % (version, telemetria.VERSION))
+        registros = []
+        for i in range(n):
+            off = TRAZA_CABECERA.size + i * TRAZA_REGISTRO.size
+            if off + TRAZA_REGISTRO.size > len(datos):
+                break
+            campos = TRAZA_REGISTRO.unpack_from(datos, off)
+            registros.append((campos[0], campos[1], campos[2:2 + DEDOS], campos[2 + DEDOS:]))
+        self.lotes.append((t_rx_us, t_envio, registros))
+        self.descartados = max(self.descartados, descartados)
+        return True
+
+    def offsets(self):
+        """Offset (reloj host - reloj mano, módulo 2^32) por lote: mínimo de su ventana y las vecinas."""
+        minimos = {}
+        for t_rx, t_envio, _ in self.lotes:
+            w = t_rx // VENTANA_OFFSET_US
+            off = ((t_rx & MASCARA) - t_envio) & MASCARA
+            if w not in minimos or off < minimos[w]:
+                minimos[w] = off
+        res = []
+        for t_rx, _, _ in self.lotes:
+            w = t_rx // VENTANA_OFFSET_US
+            res.append(min(minimos[v] for v in (w - 1, w, w + 1) if v in minimos))
+        return res
+
+    def filas(self, t_inicio_us, adelanto_us):
+        """Una fila por actualización de los servos con latencia y error."""
+        orden = sorted((t, s) for s, (t, _) in self.verdad.items())
+        tiempos = [t for t, _ in orden]
+        filas = []
+        for (t_rx, _, registros), off in zip(self.lotes, self.offsets()):
+            for t_mano, seq, valor_c, pwm in registros:
+                # Instante de aplicación en el reloj del host (siempre anterior a la llegada)
+                t_aplic = t_rx - (((t_rx & MASCARA) - ((t_mano + off) & MASCARA)) & MASCARA)
+                muestra = self.verdad.get(seq)
+                latencia = t_aplic - muestra[0] if muestra else None
+
+                # Verdad: último estado que el guante había tomado en ese instante
+                i = bisect.bisect_right(tiempos, t_aplic - adelanto_us) - 1
+                verdad = self.verdad[orden[i][1]][1] if i >= 0 else None
+                valores = [v / 100.0 for v in valor_c]
+                errores = [abs(v - r) for v, r in zip(valores, verdad)] if verdad else None
+                filas.append(dict(t_ms=(t_aplic - t_inicio_us) / 1000.0, seq=seq,
+                                  latencia_ms=None if latencia is None else latencia / 1000.0,
+                                  error_medio=None if errores is None else sum(errores) / DEDOS,
+                                  error_max=None if errores is None else max(errores),
+                                  valores=valores, verdad=verdad, pwm=pwm))
+        filas.sort(key=lambda f: f["t_ms"])
+        return filas
+
+
+def percentil(datos, p):
+    """Percentil p (0–100) por el método del rango más cercano."""
+    if not datos:
+        return float("nan")
+    orden = sorted(datos)
+    return orden[min(len(orden) - 1, max(0, int(math.ceil(p / 100.0 * len(orden))) - 1))]
+
+
+def escribir_csv(ruta, filas):
+    """Informe por actualización de los servos."""
+    cab = (["t_ms", "seq", "latencia_ms", "error_medio", "error_max"]
+           + ["valor%d" % i for i in range(DEDOS)] + ["verdad%d" % i for i in range(DEDOS)]
+           + ["pwm%d" % i for i in range(DEDOS)])
+
+    def num(x, fmt):
+        return "" if x is None else fmt % x
+
+    salida = sys.stdout if ruta == "-" else open(ruta, "w")
+    try:
+        print(",".join(cab), file=salida)
+        for f in filas:
+            verdad = f["verdad"] or [None] * DEDOS
+            campos = ([num(f["t_ms"], "%.3f"), str(f["seq"]), num(f["latencia_ms"], "%.3f"),
+                       num(f["error_medio"], "%.3f"), num(f["error_max"], "%.2f")]
+                      + ["%.2f" % v for v in f["valores"]] + [num(v, "%d") for v in verdad]
+                      + [str(p) for p in f["pwm"]])
+            print(",".join(campos), file=salida)
+    finally:
+        if salida is not sys.stdout:
+            salida.close()
+
+
+def consultar_snapshot(sock, destino, timeout):
+    """Snapshot `T?` de la mano, o None si no responde; ValueError si es de otra versión."""
+    sock.sendto(b"T?", destino)
+    limite = time.monotonic() + timeout
+    while True:
+        restante = limite - time.monotonic()
+        if restante <= 0 or not select.select([sock], [], [], restante)[0]:
+            return None
+        datos, _ = sock.recvfrom(2048)
+        try:
+            return telemetria.decodificar(datos)
+        except ValueError:
+            if datos[:4] == struct.pack("<I", telemetria.MAGIA):
+                raise  # Snapshot de otra versión del firmware
+            continue  # Un lote de traza rezagado
+
+
+def imprimir_red(args, red, enviados):
+    """Resumen de la red emulada."""
+    c = red.c
+    entregados = c["entregados"] or 1
+    print("=== red emulada (semilla %s) ===" % args.semilla)
+    print("datagramas=%d entregados=%d perdidos=%d cola=%d reordenados=%d duplicados=%d "
+          "atascados=%d retardo_medio=%.1fms retardo_max=%.1fms enviados=%d"
+          % (c["entrantes"], c["entregados"], c["perdidos"], c["cola"], c["reordenados"],
+             c["duplicados"], c["atascados"], c["retardo_total_us"] / entregados / 1000.0,
+             c["retardo_max_us"] / 1000.0, enviados))
+
+
+def imprimir_resumen(args, red, medida, filas, antes, despues, enviados):
+    """Resumen de la prueba: red emulada, mano y traza."""
+    imprimir_red(args, red, enviados)
+
+    if antes and despues:
+        campos = ("tramas", "invalidas", "estados", "recuperados", "perdidos", "desbordes",
+                  "saltados", "descartes_tardios", "aplicadas")
+        print("=== mano (diferencia de telemetría) ===")
+        print("  ".join("%s=%d" % (k, (despues[k] - antes[k]) & MASCARA) for k in campos))
+    else:
+        print("=== mano: sin telemetría `T?` ===")
+
+    print("=== traza de servos ===")
+    if not filas:
+        print("sin traza: ¿la mano es alcanzable en el puerto %d?" % telemetria.PUERTO)
+        return
+    lat = [f["latencia_ms"] for f in filas if f["latencia_ms"] is not None]
+    err = [f["error_medio"] for f in filas if f["error_medio"] is not None]
+    print("actualizaciones=%d lotes=%d descartados=%d"
+          % (len(filas), len(medida.lotes), medida.descartados))
+    if lat:
+        print("latencia_ms p50=%.1f p95=%.1f p99=%.1f max=%.1f"
+              % (percentil(lat, 50), percentil(lat, 95), percentil(lat, 99), max(lat)))
+    if err:
+        rms = math.sqrt(sum(e * e for e in err) / len(err))
+        print("error (0-9) medio=%.3f rms=%.3f p95=%.3f max=%.3f"
+              % (sum(err) / len(err), rms, percentil(err, 95), max(err)))
+
+
+def volcar(args, red, guante, sesion):
+    """Corre la prueba en tiempo virtual y escribe cada trama al entrar y al salir de la red."""
+    eventos = []   # (t_us, 0 = entra / 1 = sale, orden, datos)
+
+    def entrar(t_us, datos):
+        eventos.append((t_us, 0, len(eventos), datos))
+        for salida in red.procesar(t_us, datos):
+            eventos.append((salida, 1, len(eventos), datos))
+
+    duracion_us = int(args.duracion * 1e6)
+    if guante:
+        for t_us in range(0, duracion_us, args.periodo_us):
+            trama = guante.muestrear(t_us)
+            if trama:
+                entrar(t_us, trama)
+    else:
+        for t_us, datos in sesion:
+            if t_us >= duracion_us:
+                break
+            entrar(t_us, datos)
+
+    eventos.sort()
+    salida = sys.stdout if args.volcar == "-" else open(args.volcar, "w")
+    try:
+        for t_us, tipo, _, datos in eventos:
+            print("%s %d %s" % ("ER"[tipo], t_us, datos.decode()), file=salida)
+    finally:
+        if salida is not sys.stdout:
+            salida.close()
+    return sum(1 for e in eventos if e[1])
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("ip", nargs="?", help="IP de la mano (no hace falta con --volcar)")
+    ap.add_argument("--puerto", type=int, default=PUERTO_MANO, help="puerto de tramas de la mano")
+    ap.add_argument("--duracion", type=float, default=30.0, help="segundos de prueba")
+    ap.add_argument("--semilla", default="1", help="semilla de la red y del guante simulado")
+    ap.add_argument("--csv", help="informe por actualización de los servos ('-' = stdout)")
+    ap.add_argument("--volcar", metavar="RUTA",
+                    help="sin mano: escribir las tramas que entran (E) y salen (R) de la red ('-' = stdout)")
+    ap.add_argument("--adelanto-ms", type=float, default=0.0,
+                    help="compara cada salida con la verdad de este tiempo antes (0 = mismo instante)")
+
+    fuente = ap.add_argument_group("fuente de tramas (por defecto, guante simulado)")
+    fuente.add_argument("--sesion", help="log de consola del guante con líneas TX[n]: S,...")
+    fuente.add_argument("--escucha", type=int, help="reenviar lo que llegue a este puerto local")
+    fuente.add_argument("--periodo-us", type=int, default=2000, help="periodo de muestreo simulado")
+    fuente.add_argument("--lote", type=int, default=10, help="muestras por trama simulada")
+    fuente.add_argument("--redundancia", type=int, default=1, help="lotes previos repetidos (K)")
+
+    red = ap.add_argument_group("red emulada")
+    red.add_argument("--perdida", type=float, default=0.0, help="probabilidad de pérdida independiente")
+    red.add_argument("--rafaga", type=float, nargs=2, metavar=("P_ENTRAR", "P_SALIR"),
+                     help="pérdida en ráfagas Gilbert-Elliott")
+    red.add_argument("--retardo-ms", type=float, default=0.0, help="retardo medio")
+    red.add_argument("--jitter-ms", type=float, default=0.0, help="desviación del retardo (gaussiano)")
+    red.add_argument("--atasco", type=float, nargs=2, metavar=("PROB", "MS"),
+                     help="probabilidad por datagrama de un atasco de MS en que no sale nada")
+    red.add_argument("--reorden", type=float, default=0.0, help="probabilidad de retrasar un datagrama fuera de orden")
+    red.add_argument("--reorden-ms", type=float, default=10.0, help="retraso extra de los reordenados")
+    red.add_argument("--duplicado", type=float, default=0.0, help="probabilidad de duplicar")
+    red.add_argument("--duplicado-ms", type=float, default=1.0, help="separación de la copia")
+    red.add_argument("--ancho-kbps", type=int, default=0, help="límite de ancho de banda (0 = sin límite)")
+    red.add_argument("--cola-max-ms", type=float, default=100.0, help="espera máxima en la cola del límite")
+    args = ap.parse_args()
+    if args.volcar and args.escucha:
+        ap.error("--volcar corre en tiempo virtual y no admite --escucha")
+    if not args.volcar and not args.ip:
+        ap.error("falta la IP de la mano")
+
+    if args.volcar:
+        red = Red(args, args.semilla)
+        sesion = leer_sesion(args.sesion) if args.sesion else None
+        if args.sesion and not sesion:
+            print("emulador_red: sin tramas S en %s" % args.sesion, file=sys.stderr)
+            return 1
+        guante = None if sesion else GuanteSimulado(random.Random("%s-guante" % args.semilla),
+                                                    args.periodo_us, args.lote, args.redundancia)
+        enviados = volcar(args, red, guante, sesion)
+        if args.volcar != "-":
+            imprimir_red(args, red, enviados)
+        return 0
+
+    destino = (args.ip, args.puerto)
+    destino_tel = (args.ip, telemetria.PUERTO)
+    red = Red(args, args.semilla)
+    medida = Medida()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock_tel = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock_tel.bind(("", 0))
+    sockets = [sock, sock_tel]
+    sock_esc = None
+    origen_esc = None
+    if args.escucha:
+        sock_esc = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock_esc.bind(("", args.escucha))
+        sockets.append(sock_esc)
+
+    guante = sesion = None
+    if args.sesion:
+        sesion = leer_sesion(args.sesion)
+        if not sesion:
+            print("emulador_red: sin tramas S en %s" % args.sesion, file=sys.stderr)
+            return 1
+    elif not args.escucha:
+        guante = GuanteSimulado(random.Random("%s-guante" % args.semilla),
+                                args.periodo_us, args.lote, args.redundancia)
+
+    antes = consultar_snapshot(sock_tel, destino_tel, 0.5)
+    pendientes = []   # (t_salida_us, orden, datos)
+    orden = 0
+    enviados = 0
+
+    def entrar(t_us, datos):
+        nonlocal orden
+        medida.registrar_trama(t_us, datos)
+        for salida in red.procesar(t_us, datos):
+            heapq.heappush(pendientes, (salida, orden, datos))
+            orden += 1
+
+    t_inicio = ahora_us()
+    t_fin = t_inicio + int(args.duracion * 1e6)
+    t_drenaje = t_fin + 1000000   # Tras la prueba: salen los pendientes y llega la última traza
+    t_muestra = t_inicio
+    i_sesion = 0
+    t_renovar = t_inicio
+
+    while True:
+        ahora = ahora_us()
+        if ahora >= t_drenaje:
+            break
+
+        if ahora < t_fin:
+            if guante:
+                while t_muestra <= ahora:
+                    trama = guante.muestrear(t_muestra)
+                    if trama:
+                        entrar(t_muestra, trama)
+                    t_muestra += args.periodo_us
+            elif sesion:
+                while i_sesion < len(sesion) and t_inicio + sesion[i_sesion][0] <= ahora:
+                    entrar(t_inicio + sesion[i_sesion][0], sesion[i_sesion][1])
+                    i_sesion += 1
+
+        while pendientes and pendientes[0][0] <= ahora:
+            _, _, datos = heapq.heappop(pendientes)
+            sock.sendto(datos, destino)
+            enviados += 1
+
+        if ahora >= t_renovar:
+            sock_tel.sendto(b"R?", destino_tel)
+            t_renovar = ahora + int(RENOVAR_TRAZA_S * 1e6)
+
+        proximo = min(t_drenaje, t_renovar)
+        if pendientes:
+            proximo = min(proximo, pendientes[0][0])
+        if guante and ahora < t_fin:
+            proximo = min(proximo, t_muestra)
+        elif sesion and i_sesion < len(sesion) and ahora < t_fin:
+            proximo = min(proximo, t_inicio + sesion[i_sesion][0])
+
+        listos = select.select(sockets, [], [], max(0, proximo - ahora_us()) / 1e6)[0]
+        for s in listos:
+            datos, origen = s.recvfrom(2048)
+            t_rx = ahora_us()
+            if s is sock_tel:
+                medida.registrar_lote(t_rx, datos)
+            elif s is sock_esc:
+                origen_esc = origen
+                if t_rx < t_fin:
+                    entrar(t_rx, datos)
+            elif origen_esc:
+                sock_esc.sendto(datos, origen_esc)  # ACK y respuestas al emisor, sin degradar
+
+    sock_tel.sendto(b"R?", destino_tel)  # Vacía el último lote
+    fin_espera = time.monotonic() + 0.3
+    while time.monotonic() < fin_espera:
+        if select.select([sock_tel], [], [], 0.05)[0]:
+            datos, _ = sock_tel.recvfrom(2048)
+            medida.registrar_lote(ahora_us(), datos)
+    despues = consultar_snapshot(sock_tel, destino_tel, 0.5)
+
+    filas = medida.filas(t_inicio, int(args.adelanto_ms * 1000))
+    if args.csv:
+        escribir_csv(args.csv, filas)
+    imprimir_resumen(args, red, medida, filas, antes, despues, enviados)
+    return 0
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except ValueError as e:
+        # Snapshot o traza de un firmware con otro TELEMETRIA_VERSION
+        print("emulador_red: %s" % e, file=sys.stderr)
+        sys.exit(1)
+    except KeyboardInterrupt:
+        sys.exit(130)
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""
+huella.py - Huella de flash y RAM por módulo a partir del mapa del linker.
+
+Lee el .map que genera el SDK al enlazar (`<firmware>.elf.map`), reparte cada
+sección de entrada entre módulos según el objeto o la biblioteca de origen y
+suma los bytes que ocupa en flash y en RAM. Las secciones inicializadas en RAM
+(.data y las de SCRATCH) cuentan en ambas: su imagen se copia desde flash.
+
+Uso:
+    python3 tools/huella.py build/Pico_Server.elf.map [--secciones 20]
+
+Desde CMake: `cmake --build build --target Pico_Server_huella`.
+"""
+
+import argparse
+import re
+import sys
+from collections import defaultdict
+
+FLASH = (0x10000000, 0x11000000)
+RAM = (0x20000000, 0x20042000)
+FLASH_TOTAL = 2 * 1024 * 1024
+RAM_TOTAL = 264 * 1024
+
+# (módulo, patrón sobre la ruta del objeto); gana el primero que encaja.
+# cyw43 va antes que lwIP porque el driver trae su propio cyw43_lwip.c.
+MODULOS = (
+    ("cyw43", re.compile(r"cyw43")),
+    ("lwIP", re.compile(r"lwip")),
+    ("stdio", re.compile(r"pico_stdio|tinyusb|pico_fix/rp2040_usb")),
+    ("printf/scanf", re.compile(r"pico_printf|printf|scanf|dtoa|strtod")),
+    ("lib/servo", re.compile(r"/lib/servo/")),
+    ("lib/guante", re.compile(r"/lib/guante/")),
+)
+# Resto de bibliotecas propias (Pico_Common y lib/ de cada firmware)
+LIB_PROPIA = re.compile(r"/lib/([A-Za-z0-9_]+)/[^/]+\.c\.obj")
+APP = re.compile(r"Pico_(Client|Server)\.c\.obj")
+LIBC = re.compile(r"lib(c|m|gcc|nosys|stdc\+\+)(_nano)?\.a|libc_a-|libm_a-")
+
+# Secciones de entrada (una línea, o nombre largo y dirección en la siguiente)
+ENTRADA = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(.+))?$")
+ENTRADA_NOMBRE = re.compile(r"^ (\S+)$")
+ENTRADA_CONT = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(.+))?$")
+# Secciones de salida, con la dirección de carga si difiere (.data, SCRATCH)
+SALIDA = re.compile(r"^(\.\S+)\s*$|^\.\S+\s+0x[0-9a-fA-F]+\s+0x[0-9a-fA-F]+(?:\s+load address 0x([0-9a-fA-F]+))?")
+SALIDA_CONT = re.compile(r"^\s+0x[0-9a-fA-F]+\s+0x[0-9a-fA-F]+(?:\s+load address 0x([0-9a-fA-F]+))?\s*$")
+
+
+def modulo(objeto):
+    """Módulo al que pertenece un objeto del mapa."""
+    objeto = objeto.replace("\\", "/")
+    for nombre, patron in MODULOS:
+        if patron.search(objeto):
+            return nombre
+    m = LIB_PROPIA.search(objeto)
+    if m:
+        return "lib/" + m.group(1)
+    if APP.search(objeto):
+        return "app"
+    if LIBC.search(objeto):
+        return "libc/libgcc"
+    return "pico-sdk"
+
+
+def region(direccion):
+    """'flash', 'ram' o None según la dirección."""
+    if FLASH[0] <= direccion < FLASH[1]:
+        return "flash"
+    if RAM[0] <= direccion < RAM[1]:
+        return "ram"
+    return None
+
+
+def leer_mapa(ruta):
+    """Devuelve la lista (módulo, sección, objeto, bytes_flash, bytes_ram)."""
+    entradas = []
+    en_mapa = False
+    salida_en_flash = False  # La salida actual tiene imagen en flash (LMA)
+    salida_pendiente = False  # Nombre de salida largo: la dirección va en la línea siguiente
+    pendiente = None
+
+    with open(ruta, errors="replace") as f:
+        for linea in f:
+            linea = linea.rstrip()
+            if not en_mapa:
+                en_mapa = linea.startswith("Linker script and memory map")
+                continue
+
+            if salida_pendiente:
+                salida_pendiente = False
+                m = SALIDA_CONT.match(linea)
+                if m:
+                    salida_en_flash = bool(m.group(1)) and region(int(m.group(1), 16)) == "flash"
+                    continue
+
+            m = SALIDA.match(linea)
+            if m:
+                salida_pendiente = m.group(1) is not None
+                lma = m.group(2)
+                salida_en_flash = bool(lma) and region(int(lma, 16)) == "flash"
+                pendiente = None
+                continue
+
+            if pendiente:
+                m = ENTRADA_CONT.match(linea)
+                seccion, pendiente = pendiente, None
+                if m:
+                    dir_, tam, obj = m.groups()
+                    entradas.append((seccion, int(dir_, 16), int(tam, 16), obj, salida_en_flash))
+                continue
+
+            m = ENTRADA.match(linea)
+            if m:
+                seccion, dir_, tam, obj = m.groups()
+                entradas.append((seccion, int(dir_, 16), int(tam, 16), obj, salida_en_flash))
+                continue
+            m = ENTRADA_NOMBRE.match(linea)
+            if m and not linea.startswith(" *"):
+                pendiente = m.group(1)
+
+    if not en_mapa:
+        raise ValueError("no parece un mapa de GNU ld: %s" % ruta)
+
+    resultado = []
+    for seccion, direccion, tam, obj, con_imagen in entradas:
+        donde = region(direccion)
+        if tam == 0 or donde is None:
+            continue  # Depuración, secciones descartadas o vacías
+        obj = obj or ""
+        if seccion == "*fill*":
+            mod = "relleno"
+        elif seccion.startswith((".stack", ".heap")):
+            mod = "pilas/heap"  # Reservas del linker script (PICO_STACK_SIZE, PICO_HEAP_SIZE)
+        else:
+            mod = modulo(obj)
+        flash = tam if donde == "flash" or con_imagen else 0
+        # NOLOAD (.bss, heap, pilas) solo ocupa RAM
+        ram = tam if donde == "ram" else 0
+        resultado.append((mod, seccion, obj, flash, ram))
+    return resultado
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("mapa", help="archivo .map del linker")
+    ap.add_argument("--secciones", type=int, default=0,
+                    help="listar también las N secciones de entrada más grandes")
+    args = ap.parse_args()
+
+    try:
+        entradas = leer_mapa(args.mapa)
+    except (OSError, ValueError) as e:
+        print("huella: %s" % e, file=sys.stderr)
+        return 1
+
+    flash = defaultdict(int)
+    ram = defaultdict(int)
+    for mod, _, _, f, r in entradas:
+        flash[mod] += f
+        ram[mod] += r
+    total_flash = sum(flash.values())
+    total_ram = sum(ram.values())
+
+    print("%-18s %10s %6s %10s %6s" % ("modulo", "flash", "%", "ram", "%"))
+    for mod in sorted(flash, key=lambda m: (flash[m], ram[m]), reverse=True):
+        print("%-18s %10d %5.1f%% %10d %5.1f%%"
+              % (mod, flash[mod], 100.0 * flash[mod] / (total_flash or 1),
+                 ram[mod], 100.0 * ram[mod] / (total_ram or 1)))
+    print("%-18s %10d %5.1f%% %10d %5.1f%%  (de %d KiB flash / %d KiB RAM)"
+          % ("total", total_flash, 100.0 * total_flash / FLASH_TOTAL,
+             total_ram, 100.0 * total_ram / RAM_TOTAL, FLASH_TOTAL // 1024, RAM_TOTAL // 1024))
+
+    if args.secciones > 0:
+        print()
+        grandes = sorted(entradas, key=lambda e: max(e[3], e[4]), reverse=True)
+        for mod, seccion, obj, f, r in grandes[:args.secciones]:
+            print("%8d %8d  %-18s %s  %s" % (f, r, mod, seccion, obj.rsplit("/", 1)[-1]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
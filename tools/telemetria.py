@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""
+telemetria.py - Consulta la telemetría de la mano por UDP e imprime tasas.
+
+Envía `T?` al puerto de telemetría (4243) cada intervalo, decodifica el
+snapshot binario (ver Pico_Server/lib/telemetria/telemetria.h) y muestra las
+tasas por segundo de los contadores acumulados, el histograma de latencia, los
+tiempos de las tareas y el uso de memoria de lwIP.
+
+Uso:
+    python3 tools/telemetria.py <ip_mano> [--intervalo 1.0] [--veces 0]
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+PUERTO = 4243
+MAGIA = 0x314D4C54
+VERSION = 2
+HIST_BINS = 12
+MAX_TAREAS = 8
+
+# Mismo orden y tamaños que telemetria_snapshot_t (little-endian, empaquetado)
+CABECERA = struct.Struct("<IHHII")
+CONTADORES = ("tramas", "bytes", "invalidas", "estados", "recuperados", "perdidos",
+              "desbordes", "saltados", "descartes_tardios", "aplicadas",
+              "i2c_errores", "i2c_reintentos")
+CUERPO = struct.Struct("<%dI%dIIii" % (len(CONTADORES), HIST_BINS))
+BUCLE = struct.Struct("<HBB")
+TAREA = struct.Struct("<8sIIII")
+POOL = struct.Struct("<HHHH")
+POOLS = ("heap", "pbuf_pool", "pbuf_ref", "udp_pcb")
+WIFI = struct.Struct("<II")
+TAMANO = (CABECERA.size + CUERPO.size + BUCLE.size + MAX_TAREAS * TAREA.size
+          + len(POOLS) * POOL.size + WIFI.size)
+
+
+def decodificar(datos):
+    """Decodifica un snapshot; devuelve un dict o lanza ValueError."""
+    if len(datos) < CABECERA.size:
+        raise ValueError("respuesta corta (%d bytes)" % len(datos))
+    magia, version, tamano, uptime_ms, consultas = CABECERA.unpack_from(datos, 0)
+    if magia != MAGIA:
+        raise ValueError("magia inválida 0x%08x" % magia)
+    if version != VERSION or tamano != TAMANO or len(datos) < TAMANO:
+        raise ValueError("versión %d / tamaño %d no soportados (se espera v%d, %d bytes)"
+                         % (version, tamano, VERSION, TAMANO))
+
+    s = {"uptime_ms": uptime_ms, "consultas": consultas}
+    off = CABECERA.size
+    campos = CUERPO.unpack_from(datos, off)
+    off += CUERPO.size
+    n = len(CONTADORES)
+    s.update(zip(CONTADORES, campos[:n]))
+    s["latencia_hist"] = list(campos[n:n + HIST_BINS])
+    s["latencia_max_us"], s["playout_retardo_us"], s["playout_jitter_us"] = campos[n + HIST_BINS:]
+
+    reposo_permil, num_tareas, _ = BUCLE.unpack_from(datos, off)
+    off += BUCLE.size
+    s["reposo"] = reposo_permil / 10.0
+    s["tareas"] = []
+    for i in range(MAX_TAREAS):
+        nombre, ejec, exec_max, retraso_max, perdidos = TAREA.unpack_from(datos, off)
+        off += TAREA.size
+        if i < num_tareas:
+            s["tareas"].append((nombre.rstrip(b"\0").decode(errors="replace"),
+                                ejec, exec_max, retraso_max, perdidos))
+
+    for nombre in POOLS:
+        s[nombre] = POOL.unpack_from(datos, off)
+        off += POOL.size
+    s["wifi_caidas"], s["wifi_reconexion_ms"] = WIFI.unpack_from(datos, off)
+    return s
+
+
+def limite_cubeta(i):
+    """Texto del rango de la cubeta i del histograma log2."""
+    if i == 0:
+        return "<1ms"
+    desde = (1 << (i + 9)) / 1000.0
+    if i == HIST_BINS - 1:
+        return ">=%gms" % desde
+    return "%g-%gms" % (desde, (1 << (i + 10)) / 1000.0)
+
+
+def imprimir(s, ant, dt):
+    """Imprime un snapshot y las tasas respecto al anterior."""
+    print("--- uptime %.1fs  consultas=%d  reposo=%.1f%%  wifi_caidas=%d (ultima %dms)"
+          % (s["uptime_ms"] / 1000.0, s["consultas"], s["reposo"],
+             s["wifi_caidas"], s["wifi_reconexion_ms"]))
+
+    tasas = []
+    for c in CONTADORES:
+        if ant is None or dt <= 0:
+            tasas.append("%s=%d" % (c, s[c]))
+        else:
+            tasas.append("%s=%d (%.1f/s)" % (c, s[c], (s[c] - ant[c]) / dt))
+    print("  " + "  ".join(tasas))
+
+    if s["estados"]:
+        print("  perdida=%.2f%%" % (100.0 * s["perdidos"] / s["estados"]))
+    print("  playout retardo=%dus jitter=%dus latencia_max=%dus"
+          % (s["playout_retardo_us"], s["playout_jitter_us"], s["latencia_max_us"]))
+
+    total = sum(s["latencia_hist"]) or 1
+    for i, n in enumerate(s["latencia_hist"]):
+        if n:
+            print("  %-12s %6d %s" % (limite_cubeta(i), n, "#" * max(1, 40 * n // total)))
+
+    for nombre, ejec, exec_max, retraso_max, perdidos in s["tareas"]:
+        print("  tarea %-10s ejec=%d exec_max=%dus retraso_max=%dus plazos_perdidos=%d"
+              % (nombre, ejec, exec_max, retraso_max, perdidos))
+
+    for nombre in POOLS:
+        usado, maximo, disponible, errores = s[nombre]
+        print("  lwip %-10s usado=%d max=%d de=%d errores=%d"
+              % (nombre, usado, maximo, disponible, errores))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("ip", help="IP de la mano")
+    ap.add_argument("--puerto", type=int, default=PUERTO)
+    ap.add_argument("--intervalo", type=float, default=1.0, help="segundos entre consultas")
+    ap.add_argument("--veces", type=int, default=0, help="consultas a realizar (0 = sin fin)")
+    ap.add_argument("--timeout", type=float, default=0.5, help="espera de cada respuesta (s)")
+    args = ap.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(args.timeout)
+    ant, t_ant, n = None, None, 0
+    try:
+        while args.veces == 0 or n < args.veces:
+            n += 1
+            sock.sendto(b"T?", (args.ip, args.puerto))
+            try:
+                datos, _ = sock.recvfrom(2048)
+                s = decodificar(datos)
+            except (socket.timeout, ConnectionRefusedError):
+                print("sin respuesta de %s:%d" % (args.ip, args.puerto), file=sys.stderr)
+            except ValueError as e:
+                print("snapshot inválido: %s" % e, file=sys.stderr)
+            else:
+                dt = (s["uptime_ms"] - t_ant) / 1000.0 if t_ant is not None else 0.0
+                imprimir(s, ant, dt)
+                ant, t_ant = s, s["uptime_ms"]
+            time.sleep(args.intervalo)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())